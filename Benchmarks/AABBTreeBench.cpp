@@ -0,0 +1,197 @@
+// Measures AABBTree insertion and self query throughput, the tree quality for random and adversarial
+// insertion orders, compares the SAH bulk build against incremental insertion, and times the parallel self query
+// against the serial one (failing if their pair sets differ).
+// usage: aabbtree_bench [leafCount] [maxBuildCount] [maxThreads]   (defaults 100000, 1000000 and 16)
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include "BenchCommon.h"
+#include "../Systems/BroadPhase/AABBTree.h"
+#include "../Core/JobSystem.h"
+
+static bool lessByX(const AABB &a, const AABB &b)
+{
+    return a.min.x < b.min.x;
+}
+
+static void runCase(const char *name, const std::vector<AABB> &boxes)
+{
+    const int queryRuns = 10;
+    std::size_t leafCount = boxes.size();
+
+    std::vector<std::shared_ptr<Entity>> entities;
+    entities.reserve(leafCount);
+    for (std::size_t i = 0; i < leafCount; ++i)
+        entities.push_back(std::make_shared<Entity>());
+
+    AABBTree tree;
+    BenchTimer timer;
+    for (std::size_t i = 0; i < leafCount; ++i)
+        tree.createProxy(entities[i], boxes[i]);
+    double insertMs = timer.elapsedMilliseconds();
+
+    std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> pairs;
+    double queryUs = 0.0;
+    std::size_t nodesVisited = 0;
+    for (int run = 0; run < queryRuns; ++run)
+    {
+        pairs.clear();
+        timer.reset();
+        tree.queryPotentialCollisions(pairs);
+        queryUs += timer.elapsedMicroseconds();
+        nodesVisited += tree.getLastQueryNodesVisited();
+        doNotOptimize(pairs);
+    }
+
+    std::printf("%-10s leaves %zu  insert %.2f ms  query %.2f ms  pairs %zu  nodes visited %zu (%.1f/us)  height %d  max balance %d  area ratio %.1f\n",
+                name, leafCount, insertMs, queryUs / queryRuns / 1000.0, pairs.size(), nodesVisited / queryRuns,
+                nodesVisited / queryUs, tree.getHeight(), tree.getMaxBalance(), tree.getAreaRatio());
+}
+
+static double timeQuery(const AABBTree &tree, std::size_t &pairCount)
+{
+    const int queryRuns = 5;
+    std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> pairs;
+    BenchTimer timer;
+    for (int run = 0; run < queryRuns; ++run)
+    {
+        pairs.clear();
+        tree.queryPotentialCollisions(pairs);
+        doNotOptimize(pairs);
+    }
+    pairCount = pairs.size();
+    return timer.elapsedMilliseconds() / queryRuns;
+}
+
+static void compareBuild(std::size_t count, unsigned threads)
+{
+    std::vector<AABB> boxes = randomBoxes(count, 1234);
+    std::vector<BroadPhaseEntry> entries(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        entries[i].entity = std::make_shared<Entity>();
+        entries[i].aabb = boxes[i];
+    }
+
+    AABBTree incremental;
+    BenchTimer timer;
+    for (std::size_t i = 0; i < count; ++i)
+        incremental.createProxy(entries[i].entity, entries[i].aabb);
+    double incrementalMs = timer.elapsedMilliseconds();
+
+    std::vector<int> proxyIds;
+    AABBTree serialBuilt;
+    timer.reset();
+    serialBuilt.build(entries.data(), count, proxyIds);
+    double serialBuildMs = timer.elapsedMilliseconds();
+
+    JobSystem jobSystem(threads);
+    AABBTree parallelBuilt;
+    parallelBuilt.setJobSystem(&jobSystem);
+    timer.reset();
+    parallelBuilt.build(entries.data(), count, proxyIds);
+    double parallelBuildMs = timer.elapsedMilliseconds();
+    // both trees are queried serially
+    parallelBuilt.setJobSystem(nullptr);
+
+    std::size_t incrementalPairs, builtPairs;
+    double incrementalQueryMs = timeQuery(incremental, incrementalPairs);
+    double builtQueryMs = timeQuery(parallelBuilt, builtPairs);
+
+    std::printf("%8zu  %11.1f  %9.1f  %12.1f  %17.2f  %11.2f  %6zu  %5d / %d\n", count, incrementalMs, serialBuildMs, parallelBuildMs,
+                incrementalQueryMs, builtQueryMs, builtPairs, incremental.getHeight(), parallelBuilt.getHeight());
+    if (incrementalPairs != builtPairs)
+        std::printf("pair count mismatch: %zu vs %zu\n", incrementalPairs, builtPairs);
+}
+
+typedef std::vector<std::pair<Entity *, Entity *>> PairList;
+
+static void sortedPairs(const std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &pairs, PairList &out)
+{
+    out.clear();
+    for (const auto &pair : pairs)
+    {
+        Entity *a = pair.first.get();
+        Entity *b = pair.second.get();
+        out.push_back(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+    }
+    std::sort(out.begin(), out.end());
+}
+
+// returns the number of thread counts whose pairs differ from the serial query
+static int compareParallelQuery(std::size_t count, unsigned maxThreads)
+{
+    std::vector<AABB> boxes = randomBoxes(count, 4321);
+    std::vector<BroadPhaseEntry> entries(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        entries[i].entity = std::make_shared<Entity>();
+        entries[i].aabb = boxes[i];
+    }
+
+    AABBTree tree;
+    std::vector<int> proxyIds;
+    tree.build(entries.data(), count, proxyIds);
+
+    std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> pairs;
+    tree.queryPotentialCollisions(pairs);
+    PairList serialPairs;
+    sortedPairs(pairs, serialPairs);
+
+    std::size_t pairCount;
+    double serialMs = timeQuery(tree, pairCount);
+    std::printf("%8s  %9.2f  %7.2fx  %8zu\n", "serial", serialMs, 1.0, pairCount);
+
+    int mismatches = 0;
+    for (unsigned threads = 2; threads <= maxThreads; threads *= 2)
+    {
+        JobSystem jobSystem(threads);
+        tree.setJobSystem(&jobSystem);
+
+        pairs.clear();
+        tree.queryPotentialCollisions(pairs);
+        PairList parallelPairs;
+        sortedPairs(pairs, parallelPairs);
+        if (parallelPairs != serialPairs)
+            ++mismatches;
+
+        double ms = timeQuery(tree, pairCount);
+        std::printf("%8u  %9.2f  %7.2fx  %8zu\n", threads, ms, serialMs / ms, pairCount);
+        tree.setJobSystem(nullptr);
+    }
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t leafCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::vector<AABB> boxes = randomBoxes(leafCount, 42);
+    runCase("random", boxes);
+
+    // spawning in sorted order is the classic way to degenerate an unbalanced tree
+    std::sort(boxes.begin(), boxes.end(), lessByX);
+    runCase("sorted", boxes);
+
+    // tight clusters inserted one after another
+    std::vector<AABB> clustered = randomBoxes(leafCount, 7, 20.0f, 60.0f, 25.0f);
+    std::sort(clustered.begin(), clustered.end(), lessByX);
+    runCase("clustered", clustered);
+
+    std::size_t maxBuildCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::printf("\nbulk build vs incremental insertion (times in ms, build on %u threads)\n", threads);
+    std::printf("   boxes  incremental  sah build  sah build MT  incremental query  built query   pairs  height inc / built\n");
+    for (std::size_t count = 10000; count <= maxBuildCount; count *= 10)
+        compareBuild(count, threads);
+
+    unsigned maxThreads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 16;
+    std::printf("\nparallel self query on %zu boxes (times in ms)\n", leafCount);
+    std::printf(" threads      query  speedup     pairs\n");
+    int mismatches = compareParallelQuery(leafCount, maxThreads);
+    std::printf("thread counts with differing pair sets: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
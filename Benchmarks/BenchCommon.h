@@ -0,0 +1,56 @@
+#pragma once
+
+// Small helpers shared by the benchmark executables, they only depend on the standard library.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include "../Systems/BroadPhase/AABB.h"
+
+class BenchTimer
+{
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    void reset() { start = std::chrono::steady_clock::now(); }
+
+    double elapsedMicroseconds() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double elapsedMilliseconds() const { return elapsedMicroseconds() / 1000.0; }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// boxes of side [minSize, maxSize] scattered over a square world sized so the average box count per unit area
+// stays constant, which keeps the number of overlaps per box roughly independent of count
+inline std::vector<AABB> randomBoxes(std::size_t count, unsigned seed, float minSize = 20.0f, float maxSize = 60.0f, float spacing = 60.0f)
+{
+    std::mt19937 rng(seed);
+    float worldSize = std::sqrt(static_cast<float>(count)) * spacing;
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> size(minSize, maxSize);
+
+    std::vector<AABB> boxes;
+    boxes.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        float x = position(rng);
+        float y = position(rng);
+        float w = size(rng);
+        float h = size(rng);
+        boxes.push_back(AABB(Vector2(x, y), Vector2(x + w, y + h)));
+    }
+    return boxes;
+}
+
+// keeps the optimiser from discarding a computed value
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
@@ -0,0 +1,96 @@
+// Runs every broad phase implementation over the same scene of coherently moving boxes, reports the per frame
+// update + query time and checks that all of them report the same candidate pairs.
+// usage: broadphase_bench [boxCount] [frames]   (defaults 20000 and 60)
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include "BenchCommon.h"
+#include "../Systems/BroadPhase/AABBTree.h"
+#include "../Systems/BroadPhase/SweepAndPrune.h"
+#include "../Systems/BroadPhase/SpatialHashGrid.h"
+
+typedef std::vector<std::pair<Entity *, Entity *>> PairList;
+
+// pairs are unordered, so each one is stored smaller pointer first and the list sorted
+static void normalize(const std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &pairs, PairList &out)
+{
+    out.clear();
+    for (const auto &pair : pairs)
+    {
+        Entity *a = pair.first.get();
+        Entity *b = pair.second.get();
+        out.push_back(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+    }
+    std::sort(out.begin(), out.end());
+}
+
+// returns the frames' pair lists so runs can be compared
+static std::vector<PairList> run(const char *name, BroadPhase &broadPhase, const std::vector<std::shared_ptr<Entity>> &entities,
+                                 std::vector<AABB> boxes, const std::vector<Vector2> &velocities, int frames)
+{
+    std::vector<int> proxyIds(boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+        proxyIds[i] = broadPhase.createProxy(entities[i], boxes[i]);
+
+    std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> pairs;
+    std::vector<PairList> history(frames);
+    double totalUs = 0.0;
+    std::size_t totalPairs = 0;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (std::size_t i = 0; i < boxes.size(); ++i)
+        {
+            boxes[i].min = boxes[i].min + velocities[i];
+            boxes[i].max = boxes[i].max + velocities[i];
+        }
+
+        pairs.clear();
+        BenchTimer timer;
+        for (std::size_t i = 0; i < boxes.size(); ++i)
+            broadPhase.moveProxy(proxyIds[i], boxes[i], velocities[i]);
+        broadPhase.queryPotentialCollisions(pairs);
+        totalUs += timer.elapsedMicroseconds();
+
+        totalPairs += pairs.size();
+        normalize(pairs, history[frame]);
+    }
+
+    std::printf("%-16s %8.2f ms/frame  %8zu pairs/frame\n", name, totalUs / frames / 1000.0, totalPairs / frames);
+    return history;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t boxCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 60;
+
+    std::vector<AABB> boxes = randomBoxes(boxCount, 99, 40.0f, 60.0f);
+    std::vector<std::shared_ptr<Entity>> entities;
+    std::vector<Vector2> velocities;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+    for (std::size_t i = 0; i < boxCount; ++i)
+    {
+        entities.push_back(std::make_shared<Entity>());
+        velocities.push_back(Vector2(speed(rng), speed(rng)));
+    }
+
+    AABBTree tree;
+    SweepAndPrune sweepAndPrune;
+    SpatialHashGrid grid(64.0f);
+    std::vector<PairList> treePairs = run("AABBTree", tree, entities, boxes, velocities, frames);
+    std::vector<PairList> sapPairs = run("SweepAndPrune", sweepAndPrune, entities, boxes, velocities, frames);
+    std::vector<PairList> gridPairs = run("SpatialHashGrid", grid, entities, boxes, velocities, frames);
+
+    int mismatches = 0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        if (sapPairs[frame] != treePairs[frame] || gridPairs[frame] != treePairs[frame])
+            ++mismatches;
+    }
+    std::printf("frames with differing pair sets: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Headless run of the whole simulation (MovementSystem + CollisionSystem) on seeded scenes from 1k entities up to
+// maxEntities, for a sparse, a dense, a mixed size and a filtered scene at every count. Prints the time per frame of each phase,
+// candidate pairs and true collisions per frame, and the peak resident memory after the scene ran.
+// usage: collision_bench [maxEntities] [frames] [seed]   (defaults 1000000, 10 and 1)
+// With COLLISION_TRACE=trace.json set, the frames are also written as a Chrome trace (Perfetto loads it).
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include "BenchCommon.h"
+#include "../Core/ECS.h"
+#include "../Core/Tracer.h"
+#include "../Systems/CollisionSystem.h"
+#include "../Systems/MovementSystem.h"
+#include "../Components/VelocityComponent.h"
+#include "../Utilities/ShapeFactory.h"
+
+struct SceneConfig
+{
+    const char *name;
+    float spacing;   // world side per sqrt(entity), smaller is denser
+    float minRadius; // radii are drawn log-uniformly from [minRadius, maxRadius]
+    float maxRadius;
+    bool filtered;   // entities get one of 4 categories and ignore their own, as projectiles ignore projectiles
+};
+
+static const SceneConfig scenes[] = {
+    {"sparse", 80.0f, 10.0f, 20.0f, false},
+    {"dense", 35.0f, 10.0f, 20.0f, false},
+    {"mixed", 60.0f, 4.0f, 120.0f, false}, // mostly small shapes with a few large ones overlapping many
+    {"filtered", 35.0f, 10.0f, 20.0f, true}, // the dense scene without the quarter of pairs in the same category
+};
+
+// peak resident set size of the process so far
+static double peakMemoryMegabytes()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+#else
+    return usage.ru_maxrss / 1024.0; // kilobytes
+#endif
+}
+
+static void runScene(const SceneConfig &scene, std::size_t entityCount, int frames, unsigned seed)
+{
+    ECS ecs;
+    std::mt19937 rng(seed);
+    float worldSize = std::sqrt(static_cast<float>(entityCount)) * scene.spacing;
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> rotation(0.0f, 360.0f);
+    std::uniform_real_distribution<float> logRadius(std::log(scene.minRadius), std::log(scene.maxRadius));
+    std::uniform_real_distribution<float> speed(-60.0f, 60.0f);
+
+    for (std::size_t i = 0; i < entityCount; ++i)
+    {
+        int sides = 3 + rng() % 4;
+        float radius = std::exp(logRadius(rng));
+
+        auto entity = std::make_shared<Entity>();
+        entity->addComponent<TransformComponent>(TransformComponent(Vector2(position(rng), position(rng)), rotation(rng)));
+        entity->addComponent<VelocityComponent>(VelocityComponent(Vector2(speed(rng), speed(rng))));
+        entity->addComponent<ColliderComponent>(ColliderComponent(ShapeFactory::createRegularPolygon(sides, radius)));
+        if (scene.filtered)
+        {
+            std::uint16_t category = static_cast<std::uint16_t>(1u << (i % 4));
+            entity->addComponent<CollisionFilterComponent>(CollisionFilterComponent(category, static_cast<std::uint16_t>(0xFFFF & ~category)));
+        }
+        ecs.addEntity(entity);
+    }
+
+    MovementSystem movementSystem(ecs);
+    CollisionSystem collisionSystem(ecs);
+    Vector2 bounds(worldSize, worldSize);
+    const float deltaTime = 1.0f / 60.0f;
+
+    BenchTimer timer;
+    collisionSystem.update(); // bulk builds the broad phase
+    double buildMs = timer.elapsedMilliseconds();
+
+    double movementMs = 0.0, updateMs = 0.0, queryMs = 0.0, narrowMs = 0.0, mergeMs = 0.0;
+    std::size_t candidatePairs = 0, collisions = 0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        TRACE_SCOPE(scene.name);
+        timer.reset();
+        movementSystem.update(deltaTime, bounds);
+        movementMs += timer.elapsedMilliseconds();
+
+        collisionSystem.update();
+        CollisionSystem::Stats stats = collisionSystem.getStats();
+        updateMs += stats.treeBuildMilliseconds;
+        queryMs += stats.pairQueryMilliseconds;
+        narrowMs += stats.narrowPhaseMilliseconds;
+        mergeMs += stats.mergeMilliseconds;
+        candidatePairs += stats.candidatePairs;
+        collisions += stats.collisions;
+    }
+
+    double totalMs = movementMs + updateMs + queryMs + narrowMs + mergeMs;
+    std::printf("%-8s %8zu %9.1f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %11zu %10zu %9.1f\n", scene.name, entityCount, buildMs,
+                movementMs / frames, updateMs / frames, queryMs / frames, narrowMs / frames, mergeMs / frames, totalMs / frames,
+                candidatePairs / frames, collisions / frames, peakMemoryMegabytes());
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t maxEntities = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 10;
+    unsigned seed = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 1;
+    Tracer::startFromEnvironment();
+
+    std::printf("times in ms, per frame except the initial build, memory is the peak resident size so far in MB\n");
+    std::printf("%-8s %8s %9s %9s %9s %9s %9s %9s %9s %11s %10s %9s\n", "scene", "entities", "build", "movement", "bp update",
+                "bp query", "narrow", "merge", "total", "candidates", "collisions", "peak MB");
+
+    // smallest scenes first, so the peak memory column tracks the current scene
+    for (std::size_t count = 1000; count <= maxEntities; count *= 10)
+    {
+        for (const SceneConfig &scene : scenes)
+            runScene(scene, count, frames, seed);
+    }
+
+    if (Tracer::isEnabled() && !Tracer::stop())
+        std::fprintf(stderr, "cannot write the trace\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Times SAT against cold and warm started GJK on pairs of n-gons for growing n to find the vertex count where GJK
+// starts to win. The warm runs alternate between two poses a small step apart, like a pair from one frame to the
+// next, keeping one simplex cache per pair. Fails if GJK and SAT disagree on any pair.
+// usage: gjk_bench [pairCount] [repeats]   (defaults 2048 and 100)
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "BenchCommon.h"
+#include "../Systems/NarrowPhase/SAT.h"
+#include "../Systems/NarrowPhase/GJK.h"
+#include "../Utilities/ShapeFactory.h"
+#include "../Utilities/ColliderGeometry.h"
+
+struct PolygonPair
+{
+    ColliderComponent a;
+    ColliderComponent b;
+    ColliderComponent bMoved; // b one small step later
+};
+
+// randomly rotated n-gons of radius 30 whose centres are 0 to 90 apart
+static std::vector<PolygonPair> randomPairs(int sides, std::size_t count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::uniform_real_distribution<float> distance(0.0f, 90.0f);
+    std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+    std::vector<Vector2> local = ShapeFactory::createRegularPolygon(sides, 30.0f);
+
+    std::vector<PolygonPair> pairs;
+    pairs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        PolygonPair pair = {ColliderComponent(local), ColliderComponent(local), ColliderComponent(local)};
+        float direction = angle(rng) * 3.14159265f / 180.0f;
+        float d = distance(rng);
+        float rotation = angle(rng);
+        Vector2 position(d * std::cos(direction), d * std::sin(direction));
+        ColliderGeometry::update(TransformComponent(Vector2(0.0f, 0.0f), angle(rng)), pair.a);
+        ColliderGeometry::update(TransformComponent(position, rotation), pair.b);
+        ColliderGeometry::update(TransformComponent(position + Vector2(step(rng), step(rng)), rotation + step(rng)), pair.bMoved);
+        pairs.push_back(pair);
+    }
+    return pairs;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t pairCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2048;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    const int sideCounts[] = {3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 48, 64};
+    std::printf("%6s %12s %15s %15s %10s\n", "sides", "SAT ns/pair", "GJK cold ns/pair", "GJK warm ns/pair", "warm iters");
+
+    int mismatches = 0;
+    int crossover = 0;
+    for (int sides : sideCounts)
+    {
+        std::vector<PolygonPair> pairs = randomPairs(sides, pairCount, 2000 + sides);
+        std::vector<SimplexCache> caches(pairCount);
+
+        // cold on the first pose, then warm from that on the moved one
+        for (std::size_t i = 0; i < pairCount; ++i)
+        {
+            SimplexCache cache;
+            if (SAT::checkCollision(pairs[i].a.world, pairs[i].b.world) != GJK::checkCollision(pairs[i].a.world, pairs[i].b.world, cache))
+                ++mismatches;
+            if (SAT::checkCollision(pairs[i].a.world, pairs[i].bMoved.world) != GJK::checkCollision(pairs[i].a.world, pairs[i].bMoved.world, cache))
+                ++mismatches;
+        }
+
+        BenchTimer timer;
+        std::size_t hits = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (const auto &pair : pairs)
+                hits += SAT::checkCollision(pair.a.world, (r & 1) ? pair.bMoved.world : pair.b.world);
+        }
+        double satNs = timer.elapsedMicroseconds() * 1000.0 / (static_cast<double>(repeats) * pairCount);
+        doNotOptimize(hits);
+
+        timer.reset();
+        hits = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (const auto &pair : pairs)
+            {
+                SimplexCache cold;
+                hits += GJK::checkCollision(pair.a.world, (r & 1) ? pair.bMoved.world : pair.b.world, cold);
+            }
+        }
+        double coldNs = timer.elapsedMicroseconds() * 1000.0 / (static_cast<double>(repeats) * pairCount);
+        doNotOptimize(hits);
+
+        timer.reset();
+        std::size_t iterations = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (std::size_t i = 0; i < pairCount; ++i)
+                iterations += GJK::distance(pairs[i].a.world, (r & 1) ? pairs[i].bMoved.world : pairs[i].b.world, caches[i]).iterations;
+        }
+        double warmNs = timer.elapsedMicroseconds() * 1000.0 / (static_cast<double>(repeats) * pairCount);
+
+        if (crossover == 0 && warmNs < satNs)
+            crossover = sides;
+        std::printf("%6d %12.1f %15.1f %15.1f %10.2f\n", sides, satNs, coldNs, warmNs,
+                    static_cast<double>(iterations) / (static_cast<double>(repeats) * pairCount));
+    }
+
+    if (crossover)
+        std::printf("warm GJK overtakes SAT from %d vertices per polygon\n", crossover);
+    else
+        std::printf("SAT was faster at every vertex count\n");
+    std::printf("pairs with differing results: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+// Times the individual collision kernels on fixed seed inputs and reports ns/op and ops/s for each. Results can be
+// written as JSON and compared against a baseline written the same way: any kernel slower than its baseline by more
+// than the tolerance is a regression and makes the run exit with 1. Baselines are only comparable on the machine
+// (and build flags) they were recorded with.
+// usage: micro_bench [--json out.json] [--baseline baseline.json] [--tolerance 0.25] [--filter text]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <algorithm>
+#include "BenchCommon.h"
+#include "../Systems/NarrowPhase/SAT.h"
+#include "../Systems/BroadPhase/AABBTree.h"
+#include "../Utilities/ShapeFactory.h"
+#include "../Utilities/ColliderGeometry.h"
+#include "../Utilities/PolygonIntersection.h"
+#include "../Utilities/PolygonUtils.h"
+
+struct Result
+{
+    std::string name;
+    double nsPerOp;
+    double opsPerSecond;
+};
+
+// Runs body, which performs opsPerRun operations, often enough that a sample takes about 10 ms and keeps the
+// fastest of several samples, the one least disturbed by the rest of the machine
+template <typename F>
+static Result measure(const char *name, std::size_t opsPerRun, F body)
+{
+    const int samples = 25;
+    const double sampleMicroseconds = 10000.0;
+
+    BenchTimer timer;
+    body(); // warms caches and branch predictors, and calibrates
+    double runMicroseconds = std::max(timer.elapsedMicroseconds(), 0.001);
+    int runsPerSample = std::max(1, static_cast<int>(sampleMicroseconds / runMicroseconds));
+
+    double bestNanoseconds = 1e300;
+    for (int sample = 0; sample < samples; ++sample)
+    {
+        timer.reset();
+        for (int run = 0; run < runsPerSample; ++run)
+            body();
+        double nanoseconds = timer.elapsedMicroseconds() * 1000.0 / (static_cast<double>(runsPerSample) * opsPerRun);
+        bestNanoseconds = std::min(bestNanoseconds, nanoseconds);
+    }
+
+    Result result = {name, bestNanoseconds, 1e9 / bestNanoseconds};
+    return result;
+}
+
+// randomly rotated 3- to 6-gons of radius 30 in pairs whose centres are 0 to 90 apart, about half overlap
+static void randomPolygonPairs(std::size_t count, unsigned seed, std::vector<ColliderComponent> &shapesA, std::vector<ColliderComponent> &shapesB)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::uniform_real_distribution<float> distance(0.0f, 90.0f);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        ColliderComponent a(ShapeFactory::createRegularPolygon(3 + rng() % 4, 30.0f));
+        ColliderComponent b(ShapeFactory::createRegularPolygon(3 + rng() % 4, 30.0f));
+        float direction = angle(rng) * 3.14159265f / 180.0f;
+        float d = distance(rng);
+        ColliderGeometry::update(TransformComponent(Vector2(0.0f, 0.0f), angle(rng)), a);
+        ColliderGeometry::update(TransformComponent(Vector2(d * std::cos(direction), d * std::sin(direction)), angle(rng)), b);
+        shapesA.push_back(a);
+        shapesB.push_back(b);
+    }
+}
+
+static std::vector<Result> runBenchmarks(const std::string &filter)
+{
+    const std::size_t pairCount = 1024;
+    std::vector<ColliderComponent> shapesA, shapesB;
+    randomPolygonPairs(pairCount, 2024, shapesA, shapesB);
+
+    const std::size_t boxCount = 10000;
+    std::vector<AABB> boxes = randomBoxes(boxCount, 77);
+    std::vector<std::shared_ptr<Entity>> entities;
+    for (std::size_t i = 0; i < boxCount; ++i)
+        entities.push_back(std::make_shared<Entity>());
+
+    std::vector<Result> results;
+    std::size_t sink = 0;
+    auto wanted = [&](const char *name) { return filter.empty() || std::string(name).find(filter) != std::string::npos; };
+
+    if (wanted("SAT::checkCollision/vector"))
+    {
+        results.push_back(measure("SAT::checkCollision/vector", pairCount, [&]() {
+            for (std::size_t i = 0; i < pairCount; ++i)
+                sink += SAT::checkCollision(shapesA[i].world.vertices, shapesB[i].world.vertices);
+        }));
+    }
+
+    if (wanted("SAT::checkCollision/dispatch"))
+    {
+        results.push_back(measure("SAT::checkCollision/dispatch", pairCount, [&]() {
+            for (std::size_t i = 0; i < pairCount; ++i)
+                sink += SAT::checkCollision(shapesA[i].world, shapesB[i].world);
+        }));
+    }
+
+    if (wanted("SAT::checkCollision/cachedAxis"))
+    {
+        std::vector<SeparatingAxis> axes(pairCount);
+        std::size_t axesTested = 0;
+        results.push_back(measure("SAT::checkCollision/cachedAxis", pairCount, [&]() {
+            for (std::size_t i = 0; i < pairCount; ++i)
+                sink += SAT::checkCollision(shapesA[i].world, shapesB[i].world, axes[i], axesTested);
+        }));
+        sink += axesTested;
+    }
+
+    // every pair without a remembered axis, the full test the memoised path falls back to, against dispatch above
+    if (wanted("SAT::checkCollision/cachedAxisMiss"))
+    {
+        std::size_t axesTested = 0;
+        results.push_back(measure("SAT::checkCollision/cachedAxisMiss", pairCount, [&]() {
+            for (std::size_t i = 0; i < pairCount; ++i)
+            {
+                SeparatingAxis axis;
+                sink += SAT::checkCollision(shapesA[i].world, shapesB[i].world, axis, axesTested);
+            }
+        }));
+        sink += axesTested;
+    }
+
+    if (wanted("PolygonIntersection::computeIntersection"))
+    {
+        Vector2 polygon[PolygonIntersection::maxVertices];
+        results.push_back(measure("PolygonIntersection::computeIntersection", pairCount, [&]() {
+            for (std::size_t i = 0; i < pairCount; ++i)
+            {
+                const std::vector<Vector2> &a = shapesA[i].world.vertices;
+                const std::vector<Vector2> &b = shapesB[i].world.vertices;
+                sink += PolygonIntersection::computeIntersection(a.data(), a.size(), b.data(), b.size(), polygon);
+            }
+        }));
+    }
+
+    if (wanted("PolygonUtils::computeArea"))
+    {
+        float area = 0.0f;
+        results.push_back(measure("PolygonUtils::computeArea", pairCount, [&]() {
+            for (std::size_t i = 0; i < pairCount; ++i)
+                area += PolygonUtils::computeArea(shapesA[i].world.vertices);
+        }));
+        sink += static_cast<std::size_t>(area);
+    }
+
+    if (wanted("AABB::intersects"))
+    {
+        results.push_back(measure("AABB::intersects", boxCount, [&]() {
+            for (std::size_t i = 0; i < boxCount; ++i)
+                sink += boxes[i].intersects(boxes[(i * 7 + 1) % boxCount]);
+        }));
+    }
+
+    if (wanted("AABBTree::createProxy"))
+    {
+        results.push_back(measure("AABBTree::createProxy", boxCount, [&]() {
+            AABBTree tree;
+            for (std::size_t i = 0; i < boxCount; ++i)
+                sink += tree.createProxy(entities[i], boxes[i]);
+        }));
+    }
+
+    if (wanted("AABBTree::queryPotentialCollisions"))
+    {
+        AABBTree tree;
+        for (std::size_t i = 0; i < boxCount; ++i)
+            tree.createProxy(entities[i], boxes[i]);
+        std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> pairs;
+        // one op is one leaf's share of the self query
+        results.push_back(measure("AABBTree::queryPotentialCollisions", boxCount, [&]() {
+            pairs.clear();
+            tree.queryPotentialCollisions(pairs);
+            sink += pairs.size();
+        }));
+    }
+
+    if (wanted("AABBTree::queryAABB") || wanted("AABBTree::rayCast") || wanted("AABBTree::nearest"))
+    {
+        AABBTree tree;
+        for (std::size_t i = 0; i < boxCount; ++i)
+            tree.createProxy(entities[i], boxes[i]);
+
+        // one op is one query, around the centre of box i
+        const std::size_t queryCount = 1000;
+        if (wanted("AABBTree::queryAABB"))
+        {
+            results.push_back(measure("AABBTree::queryAABB", queryCount, [&]() {
+                for (std::size_t i = 0; i < queryCount; ++i)
+                {
+                    Vector2 centre = (boxes[i].min + boxes[i].max) * 0.5f;
+                    tree.queryAABB(AABB(centre - Vector2(50.0f, 50.0f), centre + Vector2(50.0f, 50.0f)), [&](int proxyId) {
+                        sink += proxyId;
+                        return true;
+                    });
+                }
+            }));
+        }
+
+        if (wanted("AABBTree::rayCast"))
+        {
+            // rays of about 500, every proxy reached clips the ray to half, standing in for an exact shape hit
+            results.push_back(measure("AABBTree::rayCast", queryCount, [&]() {
+                for (std::size_t i = 0; i < queryCount; ++i)
+                {
+                    Vector2 centre = (boxes[i].min + boxes[i].max) * 0.5f;
+                    AABBTree::RayCastInput input = {centre, Vector2(i % 2 ? 500.0f : -300.0f, i % 3 ? 400.0f : -200.0f), 1.0f};
+                    tree.rayCast(input, [&](const AABBTree::RayCastInput &ray, int proxyId) {
+                        sink += proxyId;
+                        return ray.maxFraction * 0.5f;
+                    });
+                }
+            }));
+        }
+
+        if (wanted("AABBTree::nearest"))
+        {
+            int nearest[8];
+            results.push_back(measure("AABBTree::nearest", queryCount, [&]() {
+                for (std::size_t i = 0; i < queryCount; ++i)
+                    sink += tree.nearest((boxes[i].min + boxes[i].max) * 0.5f, 8, nearest);
+            }));
+        }
+    }
+
+    doNotOptimize(sink);
+    return results;
+}
+
+static std::string toJson(const std::vector<Result> &results)
+{
+    std::ostringstream json;
+    json << "{\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        char line[256];
+        std::snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f}%s\n", results[i].name.c_str(),
+                      results[i].nsPerOp, results[i].opsPerSecond, i + 1 < results.size() ? "," : "");
+        json << line;
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+// Reads back what toJson wrote: every "name" followed by its "ns_per_op". Not a general JSON parser.
+static bool readBaseline(const char *path, std::vector<Result> &baseline)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    std::size_t position = 0;
+    while ((position = text.find("\"name\"", position)) != std::string::npos)
+    {
+        std::size_t open = text.find('"', text.find(':', position) + 1);
+        std::size_t close = text.find('"', open + 1);
+        std::size_t value = text.find("\"ns_per_op\"", close);
+        if (open == std::string::npos || close == std::string::npos || value == std::string::npos)
+            return false;
+
+        Result result;
+        result.name = text.substr(open + 1, close - open - 1);
+        result.nsPerOp = std::strtod(text.c_str() + text.find(':', value) + 1, nullptr);
+        result.opsPerSecond = 1e9 / result.nsPerOp;
+        baseline.push_back(result);
+        position = close;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *jsonPath = nullptr;
+    const char *baselinePath = nullptr;
+    double tolerance = 0.25;
+    std::string filter;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            jsonPath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--baseline") == 0)
+            baselinePath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--tolerance") == 0)
+            tolerance = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--filter") == 0)
+            filter = argv[i + 1];
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::vector<Result> baseline;
+    if (baselinePath && !readBaseline(baselinePath, baseline))
+    {
+        std::fprintf(stderr, "cannot read baseline %s\n", baselinePath);
+        return 2;
+    }
+
+    std::vector<Result> results = runBenchmarks(filter);
+
+    int regressions = 0;
+    std::printf("%-40s %12s %14s %12s %8s\n", "benchmark", "ns/op", "ops/s", "baseline", "change");
+    for (const Result &result : results)
+    {
+        std::printf("%-40s %12.2f %14.0f", result.name.c_str(), result.nsPerOp, result.opsPerSecond);
+
+        const Result *reference = nullptr;
+        for (const Result &entry : baseline)
+        {
+            if (entry.name == result.name)
+                reference = &entry;
+        }
+        if (!reference)
+        {
+            std::printf("%12s\n", baselinePath ? "new" : "");
+            continue;
+        }
+
+        double change = result.nsPerOp / reference->nsPerOp - 1.0;
+        bool regressed = change > tolerance;
+        regressions += regressed;
+        std::printf(" %12.2f %+7.1f%%%s\n", reference->nsPerOp, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+
+    if (jsonPath)
+    {
+        std::ofstream file(jsonPath);
+        file << toJson(results);
+        if (!file)
+        {
+            std::fprintf(stderr, "cannot write %s\n", jsonPath);
+            return 2;
+        }
+    }
+
+    if (baselinePath)
+        std::printf("%d regression(s) beyond %.0f%% tolerance\n", regressions, tolerance * 100.0);
+    return regressions == 0 ? 0 : 1;
+}
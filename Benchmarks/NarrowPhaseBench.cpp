@@ -0,0 +1,91 @@
+// Runs CollisionSystem::update on a dense static scene with job systems of 1 to maxThreads threads, reports the time
+// per frame and the speedup, and fails unless every thread count gives exactly the same pairs and manifolds.
+// usage: narrowphase_bench [entityCount] [frames] [maxThreads]   (defaults 20000 (about 200k candidate pairs), 10, 16)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "BenchCommon.h"
+#include "../Core/ECS.h"
+#include "../Core/JobSystem.h"
+#include "../Systems/CollisionSystem.h"
+#include "../Utilities/ShapeFactory.h"
+
+struct FrameResult
+{
+    std::vector<CollisionSystem::CollisionPair> pairs;
+    std::vector<ContactManifold> manifolds;
+};
+
+// manifolds are indexed like the pairs, which are compared separately
+static bool sameManifolds(const std::vector<ContactManifold> &a, const std::vector<ContactManifold> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        const ContactManifold &ma = a[i];
+        const ContactManifold &mb = b[i];
+        if (ma.pointCount != mb.pointCount ||
+            std::memcmp(&ma.normal, &mb.normal, sizeof(Vector2)) != 0 || std::memcmp(&ma.depth, &mb.depth, sizeof(float)) != 0 ||
+            std::memcmp(ma.points, mb.points, sizeof(Vector2) * ma.pointCount) != 0)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t entityCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 10;
+    unsigned maxThreads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 16;
+
+    // polygons of radius 30 spaced so each has about ten broad phase candidates
+    ECS ecs;
+    std::mt19937 rng(17);
+    float worldSize = std::sqrt(static_cast<float>(entityCount)) * 30.0f;
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> rotation(0.0f, 360.0f);
+    for (std::size_t i = 0; i < entityCount; ++i)
+    {
+        auto entity = std::make_shared<Entity>();
+        entity->addComponent<TransformComponent>(TransformComponent(Vector2(position(rng), position(rng)), rotation(rng)));
+        entity->addComponent<ColliderComponent>(ColliderComponent(ShapeFactory::createRegularPolygon(3 + rng() % 4, 30.0f)));
+        ecs.addEntity(entity);
+    }
+
+    std::printf("hardware threads %u\n", std::thread::hardware_concurrency());
+    std::printf("%8s %12s %9s %10s\n", "threads", "ms/frame", "speedup", "collisions");
+
+    FrameResult reference;
+    double singleMs = 0.0;
+    int mismatches = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        JobSystem jobSystem(threads);
+        CollisionSystem collisionSystem(ecs);
+        collisionSystem.setJobSystem(jobSystem);
+        collisionSystem.update(); // builds the tree
+
+        BenchTimer timer;
+        for (int frame = 0; frame < frames; ++frame)
+            collisionSystem.update();
+        double ms = timer.elapsedMilliseconds() / frames;
+
+        if (threads == 1)
+        {
+            singleMs = ms;
+            reference.pairs = collisionSystem.getCollisionPairs();
+            reference.manifolds = collisionSystem.getManifolds();
+        }
+        else if (collisionSystem.getCollisionPairs() != reference.pairs || !sameManifolds(collisionSystem.getManifolds(), reference.manifolds))
+        {
+            ++mismatches;
+        }
+
+        std::printf("%8u %12.2f %8.2fx %10zu\n", threads, ms, singleMs / ms, collisionSystem.getCollisionPairs().size());
+    }
+
+    std::printf("thread counts with differing results: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+// Moves a scene of polygons a few pixels per frame and runs two CollisionSystems over it, one trying each pair's
+// remembered separating axis first and one testing the axes from scratch. Reports the pair cache hit rate, the SAT
+// axes projected per pair with and without the remembered axis, and fails if the two ever report different pairs.
+// usage: paircache_bench [entityCount] [frames]   (defaults 20000 and 60)
+
+#include <cstdio>
+#include <cstdlib>
+#include "BenchCommon.h"
+#include "../Core/ECS.h"
+#include "../Systems/CollisionSystem.h"
+#include "../Components/VelocityComponent.h"
+#include "../Utilities/ShapeFactory.h"
+
+struct RunTotals
+{
+    double milliseconds;
+    std::size_t candidatePairs;
+    std::size_t cacheHits;
+    std::size_t evictedPairs;
+    std::size_t satPairs;
+    std::size_t satAxesTested;
+    std::size_t cachedAxisHits;
+    std::size_t collisions;
+
+    RunTotals()
+        : milliseconds(0.0), candidatePairs(0), cacheHits(0), evictedPairs(0), satPairs(0), satAxesTested(0), cachedAxisHits(0), collisions(0)
+    {
+    }
+
+    void add(const CollisionSystem &collisionSystem, double ms)
+    {
+        const CollisionSystem::PairCacheStats &stats = collisionSystem.getPairCacheStats();
+        milliseconds += ms;
+        candidatePairs += stats.candidatePairs;
+        cacheHits += stats.cacheHits;
+        evictedPairs += stats.evictedPairs;
+        satPairs += stats.satPairs;
+        satAxesTested += stats.satAxesTested;
+        cachedAxisHits += stats.cachedAxisHits;
+        collisions += collisionSystem.getCollisionPairs().size();
+    }
+
+    void print(const char *name, int frames) const
+    {
+        // every pair is tested with SAT, so the separated ones are the candidates that did not collide
+        std::printf("%-16s %8.2f ms/frame  hit rate %5.1f%%  evicted %6zu/frame  axes/pair %5.2f  separated pairs decided by cached axis %5.1f%%\n",
+                    name, milliseconds / frames, 100.0 * cacheHits / candidatePairs, evictedPairs / frames,
+                    static_cast<double>(satAxesTested) / satPairs, 100.0 * cachedAxisHits / (satPairs - collisions));
+    }
+};
+
+int main(int argc, char **argv)
+{
+    std::size_t entityCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 60;
+
+    // polygons of radius 30 spaced so each has about ten broad phase candidates, moving up to 2 pixels per frame
+    ECS ecs;
+    std::mt19937 rng(23);
+    float worldSize = std::sqrt(static_cast<float>(entityCount)) * 30.0f;
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> rotation(0.0f, 360.0f);
+    std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+    for (std::size_t i = 0; i < entityCount; ++i)
+    {
+        auto entity = std::make_shared<Entity>();
+        entity->addComponent<TransformComponent>(TransformComponent(Vector2(position(rng), position(rng)), rotation(rng)));
+        entity->addComponent<VelocityComponent>(VelocityComponent(Vector2(speed(rng), speed(rng))));
+        entity->addComponent<ColliderComponent>(ColliderComponent(ShapeFactory::createRegularPolygon(3 + rng() % 4, 30.0f)));
+        ecs.addEntity(entity);
+    }
+
+    CollisionSystem cached(ecs, BroadPhaseType::AABBTree, NarrowPhaseType::SAT);
+    CollisionSystem uncached(ecs, BroadPhaseType::AABBTree, NarrowPhaseType::SAT);
+    uncached.setSeparatingAxisCache(false);
+    cached.update();
+    uncached.update();
+
+    RunTotals cachedTotals, uncachedTotals;
+    int mismatches = 0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        ecs.view<TransformComponent, VelocityComponent>().each([=](Entity &, TransformComponent &transform, VelocityComponent &velocity) {
+            transform.position = transform.position + velocity.velocity;
+            if (transform.position.x < 0.0f || transform.position.x > worldSize)
+                velocity.velocity.x = -velocity.velocity.x;
+            if (transform.position.y < 0.0f || transform.position.y > worldSize)
+                velocity.velocity.y = -velocity.velocity.y;
+        });
+
+        // whichever runs second finds the geometry caches already rebuilt, so the two take turns
+        for (int run = 0; run < 2; ++run)
+        {
+            bool runCached = (run + frame) % 2 == 0;
+            CollisionSystem &collisionSystem = runCached ? cached : uncached;
+            BenchTimer timer;
+            collisionSystem.update();
+            (runCached ? cachedTotals : uncachedTotals).add(collisionSystem, timer.elapsedMilliseconds());
+        }
+
+        if (cached.getCollisionPairs() != uncached.getCollisionPairs())
+            ++mismatches;
+    }
+
+    std::printf("%zu entities, %zu candidate pairs/frame\n", entityCount, cachedTotals.candidatePairs / frames);
+    uncachedTotals.print("no axis cache", frames);
+    cachedTotals.print("axis cache", frames);
+    std::printf("frames with differing pairs: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// Compares the original vector based SAT test with the vectorised structure of arrays kernel and with the dispatched
+// test (fixed size kernels for 3 to 6 vertices) on pairs of 3- to 16-gons, about half of which overlap, and checks
+// that all of them give the same answers.
+// usage: sat_bench [pairCount] [repeats]   (defaults 4096 and 200)
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "BenchCommon.h"
+#include "../Systems/NarrowPhase/SAT.h"
+#include "../Utilities/ShapeFactory.h"
+#include "../Utilities/ColliderGeometry.h"
+
+struct PolygonPair
+{
+    ColliderComponent a;
+    ColliderComponent b;
+};
+
+// two randomly rotated n-gons of radius 30 whose centres are 0 to 90 apart
+static std::vector<PolygonPair> randomPairs(int sides, std::size_t count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::uniform_real_distribution<float> distance(0.0f, 90.0f);
+    std::vector<Vector2> local = ShapeFactory::createRegularPolygon(sides, 30.0f);
+
+    std::vector<PolygonPair> pairs;
+    pairs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        PolygonPair pair = {ColliderComponent(local), ColliderComponent(local)};
+        float direction = angle(rng) * 3.14159265f / 180.0f;
+        float d = distance(rng);
+        ColliderGeometry::update(TransformComponent(Vector2(0.0f, 0.0f), angle(rng)), pair.a);
+        ColliderGeometry::update(TransformComponent(Vector2(d * std::cos(direction), d * std::sin(direction)), angle(rng)), pair.b);
+        pairs.push_back(pair);
+    }
+    return pairs;
+}
+
+static SoAPolygon soa(const WorldGeometry &world)
+{
+    SoAPolygon polygon = {world.xs.data(), world.ys.data(), world.vertices.size(), world.xs.size()};
+    return polygon;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t pairCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::printf("SIMD lane width %zu\n", SAT::laneWidth);
+    std::printf("%6s %14s %14s %16s %9s %9s\n", "sides", "vector ns/pair", "SoA ns/pair", "dispatch ns/pair", "speedup", "overlap");
+
+    int mismatches = 0;
+    for (int sides = 3; sides <= 16; ++sides)
+    {
+        std::vector<PolygonPair> pairs = randomPairs(sides, pairCount, 1000 + sides);
+
+        std::size_t overlaps = 0;
+        for (const auto &pair : pairs)
+        {
+            bool reference = SAT::checkCollision(pair.a.world.vertices, pair.b.world.vertices);
+            if (reference != SAT::checkCollision(soa(pair.a.world), soa(pair.b.world)) ||
+                reference != SAT::checkCollision(pair.a.world, pair.b.world))
+                ++mismatches;
+            overlaps += reference;
+        }
+
+        BenchTimer timer;
+        std::size_t hits = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (const auto &pair : pairs)
+                hits += SAT::checkCollision(pair.a.world.vertices, pair.b.world.vertices);
+        }
+        double vectorNs = timer.elapsedMicroseconds() * 1000.0 / (static_cast<double>(repeats) * pairCount);
+        doNotOptimize(hits);
+
+        timer.reset();
+        hits = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (const auto &pair : pairs)
+                hits += SAT::checkCollision(soa(pair.a.world), soa(pair.b.world));
+        }
+        double soaNs = timer.elapsedMicroseconds() * 1000.0 / (static_cast<double>(repeats) * pairCount);
+        doNotOptimize(hits);
+
+        timer.reset();
+        hits = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            for (const auto &pair : pairs)
+                hits += SAT::checkCollision(pair.a.world, pair.b.world);
+        }
+        double dispatchNs = timer.elapsedMicroseconds() * 1000.0 / (static_cast<double>(repeats) * pairCount);
+        doNotOptimize(hits);
+
+        std::printf("%6d %14.1f %14.1f %16.1f %8.2fx %8.1f%%\n", sides, vectorNs, soaNs, dispatchNs,
+                    vectorNs / std::min(soaNs, dispatchNs), 100.0 * overlaps / pairCount);
+    }
+
+    std::printf("pairs with differing results: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -3,6 +3,7 @@
 #include <vector>
 #include "../Math/Vector2.h"
 #include "ShapeType.h"
+#include "WorldGeometry.h"
 
 // provides data for collision detection
 
@@ -11,6 +12,7 @@ struct ColliderComponent
     std::vector<Vector2> vertices; // Local space vertices
     Vector2 offset;                // Offset from the transform position
     ShapeType shapeType;           // Type of the shape
+    WorldGeometry world;           // cached world space geometry, see ColliderGeometry
 
     ColliderComponent(const std::vector<Vector2> &verts, ShapeType type = ShapeType::Custom, const Vector2 &off = Vector2())
         : vertices(verts), offset(off), shapeType(type) {}
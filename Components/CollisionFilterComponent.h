@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+// Which entities may collide, with Box2D's rules: two entities in the same non zero group always collide if the
+// group is positive and never if it is negative; otherwise each one's category has to be in the other's mask.
+// Entities without the component collide with everything (category 1, all mask bits, no group).
+struct CollisionFilterComponent
+{
+    std::uint16_t categoryBits; // what the entity is, usually a single bit
+    std::uint16_t maskBits;     // the categories it collides with
+    std::int16_t groupIndex;
+
+    CollisionFilterComponent(std::uint16_t category = 0x0001, std::uint16_t mask = 0xFFFF, std::int16_t group = 0)
+        : categoryBits(category), maskBits(mask), groupIndex(group) {}
+
+    bool operator==(const CollisionFilterComponent &other) const
+    {
+        return categoryBits == other.categoryBits && maskBits == other.maskBits && groupIndex == other.groupIndex;
+    }
+    bool operator!=(const CollisionFilterComponent &other) const { return !(*this == other); }
+
+    static bool shouldCollide(const CollisionFilterComponent &a, const CollisionFilterComponent &b)
+    {
+        if (a.groupIndex == b.groupIndex && a.groupIndex != 0)
+            return a.groupIndex > 0;
+        return (a.maskBits & b.categoryBits) != 0 && (b.maskBits & a.categoryBits) != 0;
+    }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include "../Math/Vector2.h"
+#include "../Systems/BroadPhase/AABB.h"
+
+// World space copy of a collider, rebuilt by ColliderGeometry::update only when the transform it was built for
+// changed. Every system reads vertices, normals and bounds from here instead of re-transforming the local shape.
+struct WorldGeometry
+{
+    std::vector<Vector2> vertices;
+    std::vector<Vector2> normals; // unit outward normal of the edge vertices[i] -> vertices[i + 1]
+
+    // the vertices again as structure of arrays for the SIMD kernels, padded to a multiple of soaPadding with
+    // copies of the first vertex so full registers can be loaded without changing any projection's min / max
+    static const size_t soaPadding = 8;
+    std::vector<float> xs;
+    std::vector<float> ys;
+
+    AABB aabb;
+    bool symmetric; // centrally symmetric: opposite edges are parallel, so half of the normals repeat
+
+    // transform the cache was built for
+    Vector2 position;
+    float rotation;
+    float scale;
+    Vector2 offset;
+    bool valid;
+
+    WorldGeometry() : symmetric(false), rotation(0.0f), scale(1.0f), valid(false) {}
+};
@@ -0,0 +1,97 @@
+#include "Archetype.h"
+#include "../Entities/Entity.h"
+#include <atomic>
+#include <cassert>
+
+int nextComponentTypeId()
+{
+    static std::atomic<int> counter(0);
+    int id = counter++;
+    assert(id < maxComponentTypes && "too many component types for ComponentMask");
+    return id;
+}
+
+Archetype::Archetype(ComponentMask mask) : mask(mask)
+{
+    for (int i = 0; i < maxComponentTypes; ++i)
+        columnIndex[i] = -1;
+}
+
+std::unique_ptr<Archetype> Archetype::createExtended(const Archetype *base, int typeId, const ComponentColumn *prototype)
+{
+    ComponentMask mask = base ? base->mask : 0;
+    if (prototype)
+        mask |= ComponentMask(1) << typeId;
+
+    std::unique_ptr<Archetype> archetype(new Archetype(mask));
+    if (base)
+    {
+        for (std::size_t i = 0; i < base->columns.size(); ++i)
+        {
+            archetype->columnIndex[base->columnTypes[i]] = static_cast<int>(archetype->columns.size());
+            archetype->columnTypes.push_back(base->columnTypes[i]);
+            archetype->columns.push_back(std::unique_ptr<ComponentColumn>(base->columns[i]->createEmpty()));
+        }
+    }
+    if (prototype && archetype->columnIndex[typeId] < 0)
+    {
+        archetype->columnIndex[typeId] = static_cast<int>(archetype->columns.size());
+        archetype->columnTypes.push_back(typeId);
+        archetype->columns.push_back(std::unique_ptr<ComponentColumn>(prototype->createEmpty()));
+    }
+    return archetype;
+}
+
+ComponentMask Archetype::getMask() const
+{
+    return mask;
+}
+
+std::size_t Archetype::size() const
+{
+    return entities.size();
+}
+
+const std::vector<Entity *> &Archetype::getEntities() const
+{
+    return entities;
+}
+
+std::size_t Archetype::moveEntityFrom(Archetype *source, std::size_t row, Entity *entity)
+{
+    std::size_t newRow = entities.size();
+    entities.push_back(entity);
+
+    if (source)
+    {
+        for (std::size_t i = 0; i < columns.size(); ++i)
+        {
+            int sourceIndex = source->columnIndex[columnTypes[i]];
+            if (sourceIndex >= 0)
+                columns[i]->moveFrom(*source->columns[sourceIndex], row);
+        }
+        source->removeRow(row);
+    }
+    return newRow;
+}
+
+void Archetype::reserve(std::size_t capacity)
+{
+    entities.reserve(capacity);
+    for (auto &column : columns)
+        column->reserve(capacity);
+}
+
+void Archetype::removeRow(std::size_t row)
+{
+    for (auto &column : columns)
+        column->swapRemove(row);
+
+    // the last entity was moved into row
+    if (row + 1 != entities.size())
+    {
+        entities[row] = entities.back();
+        entities[row]->row = row;
+    }
+    entities.pop_back();
+}
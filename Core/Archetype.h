@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+class Entity;
+
+// one bit per component type, see componentTypeId
+typedef std::uint64_t ComponentMask;
+const int maxComponentTypes = 64;
+
+// Component type ids are handed out on first use and are stable for the lifetime of the process
+int nextComponentTypeId();
+
+template <typename T>
+int componentTypeId()
+{
+    static const int id = nextComponentTypeId();
+    return id;
+}
+
+template <typename T>
+ComponentMask componentBit()
+{
+    return ComponentMask(1) << componentTypeId<T>();
+}
+
+// Type erased, contiguous storage for one component type
+class ComponentColumn
+{
+public:
+    virtual ~ComponentColumn() {}
+
+    // an empty column of the same component type
+    virtual ComponentColumn *createEmpty() const = 0;
+    // moves element row of source, a column of the same type, to the end of this column
+    virtual void moveFrom(ComponentColumn &source, std::size_t row) = 0;
+    // moves the last element into row and shrinks by one
+    virtual void swapRemove(std::size_t row) = 0;
+    virtual void reserve(std::size_t capacity) = 0;
+};
+
+template <typename T>
+class TypedColumn : public ComponentColumn
+{
+public:
+    std::vector<T> data;
+
+    ComponentColumn *createEmpty() const override { return new TypedColumn<T>(); }
+
+    void moveFrom(ComponentColumn &source, std::size_t row) override
+    {
+        data.push_back(std::move(static_cast<TypedColumn<T> &>(source).data[row]));
+    }
+
+    void swapRemove(std::size_t row) override
+    {
+        if (row + 1 != data.size())
+            data[row] = std::move(data.back());
+        data.pop_back();
+    }
+
+    void reserve(std::size_t capacity) override { data.reserve(capacity); }
+};
+
+// All entities with exactly the same set of components. Every component type has its own column and an entity
+// is the same row in all of them, so iterating a few component types over an archetype walks plain arrays.
+class Archetype
+{
+public:
+    explicit Archetype(ComponentMask mask);
+
+    // an empty archetype with base's columns plus, if prototype is given, a column like prototype for typeId
+    static std::unique_ptr<Archetype> createExtended(const Archetype *base, int typeId, const ComponentColumn *prototype);
+
+    ComponentMask getMask() const;
+    std::size_t size() const;
+    const std::vector<Entity *> &getEntities() const;
+
+    // start of the component array for T, nullptr if this archetype has no T
+    template <typename T>
+    T *column();
+
+    template <typename T>
+    T *getComponent(std::size_t row);
+
+    // pushes the last entity's T after moveEntityFrom left that column one short
+    template <typename T>
+    void appendComponent(const T &component);
+
+    // Appends entity, moving its components from row of source (if any) into the matching columns and removing
+    // the row from source. Columns source does not have are left one short for the caller to push into.
+    std::size_t moveEntityFrom(Archetype *source, std::size_t row, Entity *entity);
+
+    void reserve(std::size_t capacity);
+
+private:
+    ComponentMask mask;
+    int columnIndex[maxComponentTypes]; // -1 when the type is absent
+    std::vector<int> columnTypes;
+    std::vector<std::unique_ptr<ComponentColumn>> columns;
+    std::vector<Entity *> entities;
+
+    void removeRow(std::size_t row);
+};
+
+template <typename T>
+T *Archetype::column()
+{
+    int index = columnIndex[componentTypeId<T>()];
+    if (index < 0)
+        return nullptr;
+    return static_cast<TypedColumn<T> *>(columns[index].get())->data.data();
+}
+
+template <typename T>
+T *Archetype::getComponent(std::size_t row)
+{
+    int index = columnIndex[componentTypeId<T>()];
+    if (index < 0)
+        return nullptr;
+    return &static_cast<TypedColumn<T> *>(columns[index].get())->data[row];
+}
+
+template <typename T>
+void Archetype::appendComponent(const T &component)
+{
+    static_cast<TypedColumn<T> *>(columns[columnIndex[componentTypeId<T>()]].get())->data.push_back(component);
+}
@@ -1,7 +1,30 @@
 #include "ECS.h"
 
+ECS::ECS() : nextEntityId(0) {}
+
+ECS::~ECS()
+{
+    // entities still referenced elsewhere must not point into storage that is about to go away
+    for (const auto &entity : entities)
+    {
+        entity->archetype = nullptr;
+        entity->ecs = nullptr;
+    }
+}
+
 void ECS::addEntity(const std::shared_ptr<Entity> &entity)
 {
+    if (entity->ecs)
+        return;
+
+    Archetype *source = entity->archetype;
+    Archetype *target = getArchetype(source ? source->getMask() : 0, source, 0, nullptr);
+    entity->row = target->moveEntityFrom(source, entity->row, entity.get());
+    entity->archetype = target;
+    entity->staging.reset();
+    entity->ecs = this;
+    entity->id = nextEntityId++;
+
     entities.push_back(entity);
 }
 
@@ -9,3 +32,20 @@ const std::vector<std::shared_ptr<Entity>> &ECS::getEntities() const
 {
     return entities;
 }
+
+const std::vector<std::unique_ptr<Archetype>> &ECS::getArchetypes() const
+{
+    return archetypes;
+}
+
+Archetype *ECS::getArchetype(ComponentMask mask, const Archetype *base, int typeId, const ComponentColumn *prototype)
+{
+    auto it = archetypesByMask.find(mask);
+    if (it != archetypesByMask.end())
+        return it->second;
+
+    archetypes.push_back(Archetype::createExtended(base, typeId, prototype));
+    Archetype *archetype = archetypes.back().get();
+    archetypesByMask[mask] = archetype;
+    return archetype;
+}
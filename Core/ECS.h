@@ -2,16 +2,43 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include "Archetype.h"
+#include "View.h"
 #include "../Entities/Entity.h"
 
+// Owns the component storage: entities with the same component set share an archetype, so a system that touches
+// a few component types streams through contiguous arrays. Entity::addComponent/getComponent keep working on top.
 class ECS
 {
 public:
+    ECS();
+    ~ECS();
+
+    ECS(const ECS &) = delete;
+    ECS &operator=(const ECS &) = delete;
+
+    // moves the entity's components into the shared archetype storage and assigns its id
     void addEntity(const std::shared_ptr<Entity> &entity);
 
     const std::vector<std::shared_ptr<Entity>> &getEntities() const;
+    const std::vector<std::unique_ptr<Archetype>> &getArchetypes() const;
+
+    // entities having all of Ts, e.g. ecs.view<TransformComponent, VelocityComponent>().each(...)
+    template <typename... Ts>
+    View<Ts...> view() const
+    {
+        return View<Ts...>(archetypes);
+    }
+
+    // archetype for mask, created from base's columns plus (if given) a column like prototype for typeId
+    Archetype *getArchetype(ComponentMask mask, const Archetype *base, int typeId, const ComponentColumn *prototype);
+
     bool paused = false;
 
 private:
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype *> archetypesByMask;
     std::vector<std::shared_ptr<Entity>> entities;
+    EntityId nextEntityId;
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Counters and timers for the hot paths, cheap enough to stay on in release builds. Build with
+// -DCOLLISION_INSTRUMENTATION=0 to compile every INSTRUMENT_* use out, the counters then stay at 0.
+#ifndef COLLISION_INSTRUMENTATION
+#define COLLISION_INSTRUMENTATION 1
+#endif
+
+// Total several threads may add to at once. Relaxed, since only the sum is read, after the work is done.
+class StatCounter
+{
+public:
+    StatCounter() : value(0) {}
+
+    StatCounter(const StatCounter &) = delete;
+    StatCounter &operator=(const StatCounter &) = delete;
+
+    void add(std::uint64_t amount) { value.fetch_add(amount, std::memory_order_relaxed); }
+    std::uint64_t get() const { return value.load(std::memory_order_relaxed); }
+    void reset() { value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value;
+};
+
+// Adds the nanoseconds between its construction and destruction to a counter
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(StatCounter &nanoseconds) : nanoseconds(nanoseconds), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer()
+    {
+        nanoseconds.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    StatCounter &nanoseconds;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define INSTRUMENT_CONCAT_INNER(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_INNER(a, b)
+
+#if COLLISION_INSTRUMENTATION
+// times the rest of the enclosing scope into a StatCounter of nanoseconds
+#define INSTRUMENT_SCOPE(nanoseconds) ScopedTimer INSTRUMENT_CONCAT(scopedTimer, __LINE__)(nanoseconds)
+#define INSTRUMENT_ADD(counter, amount) (counter).add(amount)
+#else
+#define INSTRUMENT_SCOPE(nanoseconds) ((void)0)
+#define INSTRUMENT_ADD(counter, amount) ((void)0)
+#endif
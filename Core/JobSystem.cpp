@@ -0,0 +1,257 @@
+#include "JobSystem.h"
+#include "Tracer.h"
+#include <algorithm>
+
+// the system whose worker the current thread is, and its index there
+static thread_local const JobSystem *currentSystem = nullptr;
+static thread_local unsigned currentIndex = 0;
+// tasks run from inside other tasks (while waiting) are already part of the outer task's busy time
+static thread_local int taskDepth = 0;
+
+JobSystem::JobSystem(unsigned threadCount)
+    : queuedTasks(0), stopping(false), unfinishedJobs(0), lastRunMilliseconds(0.0)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+        queues.back()->busyNanoseconds = 0;
+    }
+    threadBusyMilliseconds.assign(threadCount, 0.0);
+
+    for (unsigned i = 1; i < threadCount; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+unsigned JobSystem::getThreadCount() const
+{
+    return static_cast<unsigned>(queues.size());
+}
+
+JobSystem &JobSystem::shared()
+{
+    static JobSystem system;
+    return system;
+}
+
+unsigned JobSystem::currentThread() const
+{
+    return currentSystem == this ? currentIndex : 0;
+}
+
+void JobSystem::push(Task task)
+{
+    WorkQueue &queue = *queues[currentThread()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    ++queuedTasks;
+
+    // taking the lock orders this after a sleeping worker's check of queuedTasks, so the wake up is not lost
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool JobSystem::runOne(unsigned thread)
+{
+    Task task;
+    std::size_t queueCount = queues.size();
+    for (std::size_t i = 0; i < queueCount && !task; ++i)
+    {
+        WorkQueue &queue = *queues[(thread + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        // newest own task first, it is likely still in cache; oldest stolen task first, it is likely the largest
+        if (i == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task)
+        return false;
+    --queuedTasks;
+
+    if (taskDepth++ > 0)
+    {
+        task();
+    }
+    else
+    {
+        Clock::time_point start = Clock::now();
+        task();
+        queues[thread]->busyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+    --taskDepth;
+    return true;
+}
+
+void JobSystem::waitFor(const std::atomic<std::size_t> &remaining)
+{
+    unsigned thread = currentThread();
+    while (remaining > 0)
+    {
+        if (!runOne(thread))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(unsigned thread)
+{
+    currentSystem = this;
+    currentIndex = thread;
+    for (;;)
+    {
+        if (runOne(thread))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+        if (stopping)
+            return;
+    }
+}
+
+void JobSystem::parallelFor(std::size_t count, const std::function<void(std::size_t)> &function)
+{
+    std::size_t helperCount = std::min<std::size_t>(count, queues.size()) - (count > 0 ? 1 : 0);
+    if (helperCount == 0)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    // helpers that get stolen claim indices alongside this thread, which then runs whatever else is queued until
+    // the helpers are done, so the captured locals stay alive for as long as they are used
+    std::atomic<std::size_t> nextIndex(0);
+    std::atomic<std::size_t> runningHelpers(helperCount);
+    auto claim = [&]() {
+        for (std::size_t i = nextIndex++; i < count; i = nextIndex++)
+            function(i);
+    };
+    for (std::size_t i = 0; i < helperCount; ++i)
+    {
+        push([&]() {
+            claim();
+            --runningHelpers;
+        });
+    }
+
+    claim();
+    waitFor(runningHelpers);
+}
+
+JobSystem::JobHandle JobSystem::addJob(const char *name, ComponentMask reads, ComponentMask writes, std::function<void()> work,
+                                       const std::vector<JobHandle> &dependencies)
+{
+    JobHandle handle = jobs.size();
+    std::unique_ptr<Job> job(new Job());
+    job->name = name;
+    job->reads = reads;
+    job->writes = writes;
+    job->work = std::move(work);
+    job->dependencyCount = 0;
+    job->pendingDependencies = 0;
+
+    for (JobHandle i = 0; i < handle; ++i)
+    {
+        Job &earlier = *jobs[i];
+        bool conflicts = (earlier.writes & (reads | writes)) || (writes & earlier.reads);
+        bool explicitDependency = std::find(dependencies.begin(), dependencies.end(), i) != dependencies.end();
+        if (conflicts || explicitDependency)
+        {
+            earlier.successors.push_back(handle);
+            ++job->dependencyCount;
+        }
+    }
+
+    jobs.push_back(std::move(job));
+    return handle;
+}
+
+void JobSystem::runJob(Job *job)
+{
+    job->timing.name = job->name;
+    job->timing.thread = currentThread();
+    job->timing.startMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - runStart).count();
+    {
+        TRACE_SCOPE(job->name);
+        job->work();
+    }
+    job->timing.endMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - runStart).count();
+
+    for (JobHandle successor : job->successors)
+    {
+        Job *next = jobs[successor].get();
+        if (--next->pendingDependencies == 0)
+            push([this, next]() { runJob(next); });
+    }
+    --unfinishedJobs;
+}
+
+void JobSystem::run()
+{
+    for (const std::unique_ptr<WorkQueue> &queue : queues)
+        queue->busyNanoseconds = 0;
+
+    runStart = Clock::now();
+    unfinishedJobs = jobs.size();
+    for (const std::unique_ptr<Job> &job : jobs)
+        job->pendingDependencies = job->dependencyCount;
+    for (const std::unique_ptr<Job> &job : jobs)
+    {
+        if (job->dependencyCount == 0)
+        {
+            Job *ready = job.get();
+            push([this, ready]() { runJob(ready); });
+        }
+    }
+    waitFor(unfinishedJobs);
+    lastRunMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - runStart).count();
+
+    timings.clear();
+    for (const std::unique_ptr<Job> &job : jobs)
+        timings.push_back(job->timing);
+    for (std::size_t i = 0; i < queues.size(); ++i)
+        threadBusyMilliseconds[i] = queues[i]->busyNanoseconds / 1e6;
+    jobs.clear();
+}
+
+const std::vector<JobSystem::JobTiming> &JobSystem::getTimings() const
+{
+    return timings;
+}
+
+double JobSystem::getLastRunMilliseconds() const
+{
+    return lastRunMilliseconds;
+}
+
+const std::vector<double> &JobSystem::getThreadBusyMilliseconds() const
+{
+    return threadBusyMilliseconds;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstddef>
+#include "Archetype.h"
+
+// Work stealing scheduler. Every thread owns a queue: it pushes and pops its own tasks at the back and, once that is
+// empty, steals the oldest task from the front of another thread's queue. A thread waiting for work it submitted
+// keeps running tasks meanwhile, so jobs may submit and wait for more work without deadlocking.
+//
+// On top of that sit job graphs: systems add named jobs declaring the component types they read and write, and
+// run() executes them with the ordering those declarations imply, recording when and on which thread each job ran.
+class JobSystem
+{
+public:
+    // index of a job in the graph being built, valid until the next run()
+    typedef std::size_t JobHandle;
+
+    struct JobTiming
+    {
+        const char *name;
+        unsigned thread; // 0 is the thread that called run()
+        double startMilliseconds;
+        double endMilliseconds; // both since the start of run()
+    };
+
+    // threadCount counts the calling thread, 0 means one per hardware thread
+    explicit JobSystem(unsigned threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // workers plus the calling thread
+    unsigned getThreadCount() const;
+
+    // Adds a job to the graph of the next run(). It starts after every job added before it whose access conflicts
+    // with its own (one of them writes a component type the other reads or writes) and after dependencies, which
+    // allows finer ordering than whole component types, e.g. between chunks of the same system.
+    JobHandle addJob(const char *name, ComponentMask reads, ComponentMask writes, std::function<void()> work,
+                     const std::vector<JobHandle> &dependencies = std::vector<JobHandle>());
+
+    // Runs the graph and returns once every job finished, then clears it. The calling thread runs jobs too.
+    // Graphs are built and run from one thread at a time, and not from inside a job.
+    void run();
+
+    // one entry per job of the last run, in the order they were added
+    const std::vector<JobTiming> &getTimings() const;
+    double getLastRunMilliseconds() const;
+    // per thread time spent running tasks during the last run, compare with getLastRunMilliseconds for the usage
+    const std::vector<double> &getThreadBusyMilliseconds() const;
+
+    // Calls task(i) once for every i in [0, count) and returns when all calls finished. Indices are claimed one at a
+    // time, so make each one a chunk of work. Safe to call from inside jobs and tasks.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &task);
+
+    // process wide system sized to the hardware
+    static JobSystem &shared();
+
+private:
+    typedef std::function<void()> Task;
+    typedef std::chrono::steady_clock Clock;
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<long long> busyNanoseconds;
+    };
+
+    struct Job
+    {
+        const char *name;
+        ComponentMask reads;
+        ComponentMask writes;
+        std::function<void()> work;
+        std::vector<JobHandle> successors;
+        unsigned dependencyCount;
+        std::atomic<unsigned> pendingDependencies;
+        JobTiming timing;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues; // queues[0] is shared by every thread outside the system
+    std::atomic<std::size_t> queuedTasks;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    std::vector<std::unique_ptr<Job>> jobs;
+    std::atomic<std::size_t> unfinishedJobs;
+    Clock::time_point runStart;
+    std::vector<JobTiming> timings;
+    double lastRunMilliseconds;
+    std::vector<double> threadBusyMilliseconds;
+
+    unsigned currentThread() const;
+    void push(Task task);
+    bool runOne(unsigned thread);
+    void waitFor(const std::atomic<std::size_t> &remaining);
+    void runJob(Job *job);
+    void workerLoop(unsigned thread);
+};
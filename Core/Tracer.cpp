@@ -0,0 +1,118 @@
+#include "Tracer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *name;
+        std::uint64_t beginNanoseconds;
+        std::uint64_t endNanoseconds;
+    };
+
+    // Written only by its thread. The count is published with release after the slot is filled, so stop() reads
+    // complete events as long as the writer is not lapping it at the same time.
+    struct ThreadBuffer
+    {
+        unsigned thread;
+        std::vector<TraceEvent> events;
+        std::atomic<std::uint64_t> written;
+    };
+}
+
+std::atomic<bool> Tracer::enabled(false);
+
+static std::chrono::steady_clock::time_point startTime;
+static std::string outputPath;
+// every buffer ever handed out, threads keep theirs for the life of the process
+static std::mutex buffersMutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+static thread_local ThreadBuffer *threadBuffer = nullptr;
+
+static ThreadBuffer *registerThread()
+{
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->events.resize(Tracer::bufferCapacity);
+    buffer->written = 0;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->thread = static_cast<unsigned>(buffers.size());
+    buffers.push_back(std::move(buffer));
+    return buffers.back().get();
+}
+
+void Tracer::start(const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (const std::unique_ptr<ThreadBuffer> &buffer : buffers)
+            buffer->written = 0;
+    }
+    outputPath = path;
+    startTime = std::chrono::steady_clock::now();
+    enabled.store(true, std::memory_order_release);
+}
+
+bool Tracer::startFromEnvironment()
+{
+    const char *path = std::getenv("COLLISION_TRACE");
+    if (!path || !*path)
+        return false;
+    start(path);
+    return true;
+}
+
+std::uint64_t Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Tracer::record(const char *name, std::uint64_t beginNanoseconds, std::uint64_t endNanoseconds)
+{
+    if (!threadBuffer)
+        threadBuffer = registerThread();
+
+    std::uint64_t index = threadBuffer->written.load(std::memory_order_relaxed);
+    TraceEvent &event = threadBuffer->events[index & (bufferCapacity - 1)];
+    event.name = name;
+    event.beginNanoseconds = beginNanoseconds;
+    event.endNanoseconds = endNanoseconds;
+    threadBuffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::stop()
+{
+    if (!enabled.exchange(false))
+        return false;
+
+    std::FILE *file = std::fopen(outputPath.c_str(), "w");
+    if (!file)
+        return false;
+
+    // complete ("X") events in microseconds, one process with a track per thread
+    std::fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : buffers)
+    {
+        std::fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"thread %u\"}}",
+                     first ? "" : ",\n", buffer->thread, buffer->thread);
+        first = false;
+
+        std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+        std::uint64_t oldest = written > bufferCapacity ? written - bufferCapacity : 0;
+        for (std::uint64_t i = oldest; i < written; ++i)
+        {
+            const TraceEvent &event = buffer->events[i & (bufferCapacity - 1)];
+            std::fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}", event.name,
+                         buffer->thread, event.beginNanoseconds / 1000.0, (event.endNanoseconds - event.beginNanoseconds) / 1000.0);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Instrumentation.h"
+
+// Opt-in timeline of named scopes, written as a Chrome trace event file that chrome://tracing and Perfetto
+// (ui.perfetto.dev) load. Every thread records into its own ring buffer without taking locks; once a buffer is full
+// its oldest events are overwritten, so a long run keeps its most recent stretch. Recording is off until start().
+class Tracer
+{
+public:
+    // events kept per thread, the oldest are dropped beyond that
+    static const std::size_t bufferCapacity = 1 << 16;
+
+    // starts recording, events are written to path by stop(). Clears events left from an earlier start.
+    static void start(const std::string &path);
+
+    // starts recording if the COLLISION_TRACE environment variable names an output file
+    static bool startFromEnvironment();
+
+    // Stops recording and writes the events of every thread, returns false if not started or the file could not be written.
+    // Call it while no thread is inside a traced scope, e.g. between frames or at exit.
+    static bool stop();
+
+    static bool isEnabled() { return enabled.load(std::memory_order_acquire); }
+
+    // nanoseconds since start()
+    static std::uint64_t now();
+
+    // name must outlive the tracer, string literals and job names are fine
+    static void record(const char *name, std::uint64_t beginNanoseconds, std::uint64_t endNanoseconds);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records the enclosing scope as one complete event, costs an atomic load when tracing is off
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *scopeName) : name(Tracer::isEnabled() ? scopeName : nullptr), begin(name ? Tracer::now() : 0) {}
+
+    ~TraceScope()
+    {
+        if (name)
+            Tracer::record(name, begin, Tracer::now());
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+    std::uint64_t begin;
+};
+
+#if COLLISION_INSTRUMENTATION
+#define TRACE_SCOPE(name) TraceScope INSTRUMENT_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
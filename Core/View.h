@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include "Archetype.h"
+#include "../Entities/Entity.h"
+
+class JobSystem;
+
+inline ComponentMask combineMasks()
+{
+    return 0;
+}
+
+template <typename... Rest>
+ComponentMask combineMasks(ComponentMask first, Rest... rest)
+{
+    return first | combineMasks(rest...);
+}
+
+// the bits of Ts, e.g. to declare the component types a job reads or writes
+template <typename... Ts>
+ComponentMask componentMask()
+{
+    return combineMasks(componentBit<Ts>()...);
+}
+
+// Iterates the entities that have all of Ts, archetype by archetype, handing the callback direct references into
+// the component columns: f(Entity &, Ts &...). Only archetypes whose mask contains the view's signature are visited,
+// so there is no per entity lookup or null check. Created through ECS::view.
+template <typename... Ts>
+class View
+{
+public:
+    explicit View(const std::vector<std::unique_ptr<Archetype>> &archetypes);
+
+    // the signature, one bit per component type of Ts
+    static ComponentMask mask();
+
+    // number of matching entities
+    std::size_t size() const;
+
+    template <typename F>
+    void each(F f) const;
+
+    // Same as each, but the matching rows are cut into chunks of chunkSize that run on jobSystem.
+    // f may only touch the components it is given, chunks run in no particular order.
+    template <typename F>
+    void parallelEach(JobSystem &jobSystem, F f, std::size_t chunkSize = 1024) const;
+
+    // parallelEach on JobSystem::shared()
+    template <typename F>
+    void parallelEach(F f, std::size_t chunkSize = 1024) const;
+
+private:
+    std::vector<Archetype *> matches;
+
+    template <typename F, typename... Columns>
+    static void eachRow(Entity *const *entities, std::size_t begin, std::size_t end, F &f, Columns *... columns);
+
+    template <typename F>
+    static void eachInRange(Archetype &archetype, std::size_t begin, std::size_t end, F &f);
+};
+
+#include "View.inl"
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include "JobSystem.h"
+
+template <typename... Ts>
+View<Ts...>::View(const std::vector<std::unique_ptr<Archetype>> &archetypes)
+{
+    ComponentMask signature = mask();
+    for (const auto &archetype : archetypes)
+    {
+        if ((archetype->getMask() & signature) == signature && archetype->size() > 0)
+            matches.push_back(archetype.get());
+    }
+}
+
+template <typename... Ts>
+ComponentMask View<Ts...>::mask()
+{
+    static const ComponentMask signature = combineMasks(componentBit<Ts>()...);
+    return signature;
+}
+
+template <typename... Ts>
+std::size_t View<Ts...>::size() const
+{
+    std::size_t count = 0;
+    for (Archetype *archetype : matches)
+        count += archetype->size();
+    return count;
+}
+
+template <typename... Ts>
+template <typename F, typename... Columns>
+void View<Ts...>::eachRow(Entity *const *entities, std::size_t begin, std::size_t end, F &f, Columns *... columns)
+{
+    for (std::size_t row = begin; row < end; ++row)
+    {
+        f(*entities[row], columns[row]...);
+    }
+}
+
+template <typename... Ts>
+template <typename F>
+void View<Ts...>::eachInRange(Archetype &archetype, std::size_t begin, std::size_t end, F &f)
+{
+    eachRow(archetype.getEntities().data(), begin, end, f, archetype.template column<Ts>()...);
+}
+
+template <typename... Ts>
+template <typename F>
+void View<Ts...>::each(F f) const
+{
+    for (Archetype *archetype : matches)
+    {
+        eachInRange(*archetype, 0, archetype->size(), f);
+    }
+}
+
+template <typename... Ts>
+template <typename F>
+void View<Ts...>::parallelEach(JobSystem &jobSystem, F f, std::size_t chunkSize) const
+{
+    struct Chunk
+    {
+        Archetype *archetype;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    std::vector<Chunk> chunks;
+    for (Archetype *archetype : matches)
+    {
+        for (std::size_t begin = 0; begin < archetype->size(); begin += chunkSize)
+        {
+            Chunk chunk = {archetype, begin, std::min(begin + chunkSize, archetype->size())};
+            chunks.push_back(chunk);
+        }
+    }
+
+    // workers and the calling thread claim chunks until none are left
+    jobSystem.parallelFor(chunks.size(), [&](std::size_t i) {
+        eachInRange(*chunks[i].archetype, chunks[i].begin, chunks[i].end, f);
+    });
+}
+
+template <typename... Ts>
+template <typename F>
+void View<Ts...>::parallelEach(F f, std::size_t chunkSize) const
+{
+    parallelEach(JobSystem::shared(), f, chunkSize);
+}
@@ -0,0 +1,33 @@
+#include "Entity.h"
+#include "../Core/ECS.h"
+
+Entity::Entity() : ecs(nullptr), id(invalidEntityId), archetype(nullptr), row(0) {}
+
+EntityId Entity::getId() const
+{
+    return id;
+}
+
+bool Entity::hasComponents(ComponentMask mask) const
+{
+    return archetype && (archetype->getMask() & mask) == mask;
+}
+
+Archetype *Entity::migrate(int typeId, const ComponentColumn &prototype)
+{
+    if (ecs)
+    {
+        ComponentMask mask = (archetype ? archetype->getMask() : 0) | (ComponentMask(1) << typeId);
+        Archetype *target = ecs->getArchetype(mask, archetype, typeId, &prototype);
+        row = target->moveEntityFrom(archetype, row, this);
+        archetype = target;
+        return target;
+    }
+
+    // not registered yet, the old staging archetype has to outlive the move
+    std::unique_ptr<Archetype> newStaging = Archetype::createExtended(archetype, typeId, &prototype);
+    row = newStaging->moveEntityFrom(archetype, row, this);
+    archetype = newStaging.get();
+    staging = std::move(newStaging);
+    return archetype;
+}
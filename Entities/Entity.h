@@ -1,21 +1,53 @@
 #pragma once
 
-#include <unordered_map>
-#include <typeindex>
 #include <memory>
+#include <cstdint>
+#include "../Core/Archetype.h"
 
-class Entity
+class ECS;
+
+// Handed out by ECS::addEntity in registration order and never reused, so unlike Entity pointers they make
+// stable, deterministic keys for per entity and per pair state
+typedef std::uint32_t EntityId;
+const EntityId invalidEntityId = ~EntityId(0);
+
+// An entity is a row in an archetype. Components added before the entity is handed to ECS::addEntity live in a
+// private single row archetype and move into the ECS' shared storage on registration. Adding a component to a
+// registered entity moves it to the archetype for its new component set.
+// Pointers returned by getComponent stay valid until an entity is added to the ECS or gains a component.
+class Entity : public std::enable_shared_from_this<Entity>
 {
 public:
+    Entity();
+
+    Entity(const Entity &) = delete;
+    Entity &operator=(const Entity &) = delete;
+
     template <typename T>
     void addComponent(const T &component);
 
     template <typename T>
     T *getComponent();
+
+    bool hasComponents(ComponentMask mask) const;
+
+    // invalidEntityId until the entity is registered
+    EntityId getId() const;
     bool paused = false;
 
 private:
-    std::unordered_map<std::type_index, std::shared_ptr<void>> components;
+    friend class ECS;
+    friend class Archetype;
+
+    ECS *ecs;             // set once registered
+    EntityId id;
+    Archetype *archetype; // nullptr until the first component is added
+    std::size_t row;
+    std::unique_ptr<Archetype> staging; // owns archetype while the entity is not registered
+
+    // moves this entity to the archetype holding its current components plus typeId (built from prototype if it
+    // does not exist yet) and returns it, the new component is left for the caller to append
+    Archetype *migrate(int typeId, const ComponentColumn &prototype);
 };
 
 #include "Entity.inl"
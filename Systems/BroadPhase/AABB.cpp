@@ -1,4 +1,5 @@
 #include "AABB.h"
+#include <algorithm>
 // represesnts an axis-aligned bounding box for broad phase collision detection
 AABB::AABB() : min(Vector2()), max(Vector2()) {}
 
@@ -9,3 +10,20 @@ bool AABB::intersects(const AABB &other) const
     return (min.x <= other.max.x && max.x >= other.min.x) &&
            (min.y <= other.max.y && max.y >= other.min.y);
 }
+
+bool AABB::contains(const AABB &other) const
+{
+    return min.x <= other.min.x && min.y <= other.min.y &&
+           other.max.x <= max.x && other.max.y <= max.y;
+}
+
+float AABB::perimeter() const
+{
+    return 2.0f * ((max.x - min.x) + (max.y - min.y));
+}
+
+AABB AABB::merge(const AABB &a, const AABB &b)
+{
+    return AABB(Vector2(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)),
+                Vector2(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)));
+}
@@ -10,4 +10,12 @@ struct AABB
     AABB(const Vector2 &min, const Vector2 &max);
 
     bool intersects(const AABB &other) const;
+
+    // true if other lies completely inside this box
+    bool contains(const AABB &other) const;
+
+    float perimeter() const;
+
+    // smallest box enclosing both a and b
+    static AABB merge(const AABB &a, const AABB &b);
 };
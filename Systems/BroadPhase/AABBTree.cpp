@@ -1,144 +1,719 @@
 #include "AABBTree.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <iterator>
+#include "../../Core/JobSystem.h"
 
-AABBTreeNode::AABBTreeNode() : aabb(), entity(nullptr), left(nullptr), right(nullptr) {}
+static_assert(sizeof(AABBTreeNode) == 32, "AABBTreeNode should stay 32 bytes, two nodes per cache line");
 
-AABBTreeNode::AABBTreeNode(const AABB &box, const std::shared_ptr<Entity> &ent)
-    : aabb(box), entity(ent), left(nullptr), right(nullptr) {}
+const std::int32_t AABBTree::nullNode;
 
-AABBTree::AABBTree() : root(nullptr) {}
-
-void AABBTree::insert(const std::shared_ptr<Entity> &entity, const AABB &aabb)
+AABBTree::AABBTree(float fatMargin)
+    : BroadPhase(fatMargin), root(nullNode), freeList(nullNode), nodeCount(0), lastQueryNodesVisited(0), jobSystem(nullptr)
 {
-    insertNode(root, entity, aabb);
+    growPool(16);
 }
 
-void AABBTree::insertNode(std::shared_ptr<AABBTreeNode> &currentNode, const std::shared_ptr<Entity> &entity, const AABB &aabb)
+void AABBTree::growPool(int capacity)
 {
-    if (!currentNode)
+    int oldCapacity = static_cast<int>(nodes.size());
+    nodes.resize(capacity);
+    entities.resize(capacity);
+    filters.resize(capacity);
+    filterBits.resize(capacity);
+
+    // chain the new nodes onto the free list
+    for (int i = oldCapacity; i < capacity; ++i)
     {
-        currentNode = std::make_shared<AABBTreeNode>(aabb, entity);
-        return;
+        nodes[i].parent = i + 1 < capacity ? i + 1 : freeList;
+        nodes[i].left = nullNode;
+        nodes[i].right = nullNode;
+        nodes[i].height = -1;
     }
+    freeList = oldCapacity;
+}
 
-    // if current node is leaf
-    if (currentNode->entity)
+std::int32_t AABBTree::allocateNode()
+{
+    if (freeList == nullNode)
     {
-        // Convert leaf node to internal node
-        auto oldEntity = currentNode->entity;
-        auto oldAABB = currentNode->aabb;
+        growPool(static_cast<int>(nodes.size()) * 2);
+    }
 
-        currentNode->entity = nullptr;
+    std::int32_t index = freeList;
+    AABBTreeNode &node = nodes[index];
+    freeList = node.parent;
 
-        currentNode->left = std::make_shared<AABBTreeNode>(oldAABB, oldEntity);
-        currentNode->right = std::make_shared<AABBTreeNode>(aabb, entity);
+    node.parent = nullNode;
+    node.left = nullNode;
+    node.right = nullNode;
+    node.height = 0;
+    ++nodeCount;
+    return index;
+}
+
+void AABBTree::freeNode(std::int32_t index)
+{
+    nodes[index].parent = freeList;
+    nodes[index].height = -1;
+    entities[index].reset();
+    freeList = index;
+    --nodeCount;
+}
+
+void AABBTree::insert(const std::shared_ptr<Entity> &entity, const AABB &aabb)
+{
+    createProxy(entity, aabb);
+}
+
+int AABBTree::createProxy(const std::shared_ptr<Entity> &entity, const AABB &aabb, const CollisionFilterComponent &filter)
+{
+    std::int32_t proxyId = allocateNode();
+    nodes[proxyId].aabb = fatten(aabb, Vector2());
+    entities[proxyId] = entity;
+    setLeafFilter(proxyId, filter);
+    insertLeaf(proxyId);
+    return proxyId;
+}
+
+bool AABBTree::moveProxy(int proxyId, const AABB &aabb, const Vector2 &displacement)
+{
+    AABB fatAABB = fatten(aabb, displacement);
+    if (fatAABBStillValid(nodes[proxyId].aabb, aabb, fatAABB))
+        return false;
+
+    removeLeaf(proxyId);
+    nodes[proxyId].aabb = fatAABB;
+    insertLeaf(proxyId);
+    return true;
+}
+
+void AABBTree::destroyProxy(int proxyId)
+{
+    removeLeaf(proxyId);
+    freeNode(proxyId);
+}
 
-        // Update parent AABB
-        currentNode->aabb.min.x = std::min(currentNode->left->aabb.min.x, currentNode->right->aabb.min.x);
-        currentNode->aabb.min.y = std::min(currentNode->left->aabb.min.y, currentNode->right->aabb.min.y);
-        currentNode->aabb.max.x = std::max(currentNode->left->aabb.max.x, currentNode->right->aabb.max.x);
-        currentNode->aabb.max.y = std::max(currentNode->left->aabb.max.y, currentNode->right->aabb.max.y);
+void AABBTree::build(const BroadPhaseEntry *entries, std::size_t count, std::vector<int> &proxyIds)
+{
+    proxyIds.resize(count);
+
+    // Leaves take indices [0, count) and internal nodes [count, 2 * count - 1), any spare capacity becomes the free list
+    int leafCount = static_cast<int>(count);
+    int usedNodes = leafCount > 0 ? 2 * leafCount - 1 : 0;
+    nodes.clear();
+    entities.clear();
+    filters.clear();
+    filterBits.clear();
+    freeList = nullNode;
+    growPool(std::max(usedNodes, 16));
+    freeList = usedNodes < static_cast<int>(nodes.size()) ? usedNodes : nullNode;
+    nodeCount = usedNodes;
+    root = nullNode;
+
+    if (leafCount == 0)
+        return;
+
+    std::vector<std::int32_t> leaves(leafCount);
+    for (int i = 0; i < leafCount; ++i)
+    {
+        AABBTreeNode &leaf = nodes[i];
+        leaf.aabb = fatten(entries[i].aabb, Vector2());
+        leaf.parent = nullNode;
+        leaf.left = nullNode;
+        leaf.right = nullNode;
+        leaf.height = 0;
+        entities[i] = entries[i].entity;
+        setLeafFilter(i, entries[i].filter);
+        leaves[i] = i;
+        proxyIds[i] = i;
     }
-    else
+
+    root = buildRange(leaves.data(), leafCount, leafCount);
+    nodes[root].parent = nullNode;
+}
+
+// splits with a side smaller than this build both sides on the calling thread
+static const std::int32_t parallelBuildCutoff = 4096;
+static const int buildBinCount = 16;
+
+// Builds the subtree over leaves[0, count) and returns its root. A subtree of n leaves owns the n - 1 internal
+// nodes starting at firstInternal, so both halves can be built concurrently without sharing an allocator.
+std::int32_t AABBTree::buildRange(std::int32_t *leaves, std::int32_t count, std::int32_t firstInternal)
+{
+    if (count == 1)
+        return leaves[0];
+
+    // bounds of the leaf centres decide the split axis and the bins
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (std::int32_t i = 0; i < count; ++i)
     {
-        // Update AABB to encompass the new entity's AABB as well
-        currentNode->aabb.min.x = std::min(currentNode->aabb.min.x, aabb.min.x);
-        currentNode->aabb.min.y = std::min(currentNode->aabb.min.y, aabb.min.y);
-        currentNode->aabb.max.x = std::max(currentNode->aabb.max.x, aabb.max.x);
-        currentNode->aabb.max.y = std::max(currentNode->aabb.max.y, aabb.max.y);
+        const AABB &box = nodes[leaves[i]].aabb;
+        float cx = 0.5f * (box.min.x + box.max.x);
+        float cy = 0.5f * (box.min.y + box.max.y);
+        minX = std::min(minX, cx);
+        minY = std::min(minY, cy);
+        maxX = std::max(maxX, cx);
+        maxY = std::max(maxY, cy);
+    }
+
+    bool splitX = (maxX - minX) >= (maxY - minY);
+    float axisMin = splitX ? minX : minY;
+    float extent = splitX ? maxX - minX : maxY - minY;
 
-        // Heuristic: insert into the child with smaller increase in perimeter
-        float leftPerimeterIncrease = 0.0f;
-        float rightPerimeterIncrease = 0.0f;
+    std::int32_t leftCount = count / 2;
+    if (extent > 0.0f)
+    {
+        // Bin the leaves by centre and evaluate the SAH cost (count * perimeter on each side) of every bin boundary
+        int binCounts[buildBinCount] = {0};
+        AABB binBoxes[buildBinCount];
+        float binScale = buildBinCount / extent;
 
-        if (currentNode->left)
+        for (std::int32_t i = 0; i < count; ++i)
         {
-            AABB leftUnion = currentNode->left->aabb;
-            leftUnion.min.x = std::min(leftUnion.min.x, aabb.min.x);
-            leftUnion.min.y = std::min(leftUnion.min.y, aabb.min.y);
-            leftUnion.max.x = std::max(leftUnion.max.x, aabb.max.x);
-            leftUnion.max.y = std::max(leftUnion.max.y, aabb.max.y);
-
-            leftPerimeterIncrease = (leftUnion.max.x - leftUnion.min.x + leftUnion.max.y - leftUnion.min.y) * 2.0f -
-                                    (currentNode->left->aabb.max.x - currentNode->left->aabb.min.x + currentNode->left->aabb.max.y - currentNode->left->aabb.min.y) * 2.0f;
+            const AABB &box = nodes[leaves[i]].aabb;
+            float centre = splitX ? 0.5f * (box.min.x + box.max.x) : 0.5f * (box.min.y + box.max.y);
+            int bin = std::min(static_cast<int>((centre - axisMin) * binScale), buildBinCount - 1);
+            binBoxes[bin] = binCounts[bin] == 0 ? box : AABB::merge(binBoxes[bin], box);
+            ++binCounts[bin];
         }
 
-        if (currentNode->right)
+        // rightCost[b] is the cost of everything in bins [b, binCount)
+        float rightCost[buildBinCount];
+        int rightCount = 0;
+        AABB rightBox;
+        for (int b = buildBinCount - 1; b > 0; --b)
         {
-            AABB rightUnion = currentNode->right->aabb;
-            rightUnion.min.x = std::min(rightUnion.min.x, aabb.min.x);
-            rightUnion.min.y = std::min(rightUnion.min.y, aabb.min.y);
-            rightUnion.max.x = std::max(rightUnion.max.x, aabb.max.x);
-            rightUnion.max.y = std::max(rightUnion.max.y, aabb.max.y);
-
-            rightPerimeterIncrease = (rightUnion.max.x - rightUnion.min.x + rightUnion.max.y - rightUnion.min.y) * 2.0f -
-                                     (currentNode->right->aabb.max.x - currentNode->right->aabb.min.x + currentNode->right->aabb.max.y - currentNode->right->aabb.min.y) * 2.0f;
+            if (binCounts[b] > 0)
+            {
+                rightBox = rightCount == 0 ? binBoxes[b] : AABB::merge(rightBox, binBoxes[b]);
+                rightCount += binCounts[b];
+            }
+            rightCost[b] = rightCount * (rightCount > 0 ? rightBox.perimeter() : 0.0f);
         }
 
-        if (!currentNode->left || leftPerimeterIncrease <= rightPerimeterIncrease)
+        float bestCost = FLT_MAX;
+        int bestSplit = -1;
+        int leftSideCount = 0;
+        AABB leftBox;
+        for (int b = 0; b < buildBinCount - 1; ++b)
         {
-            insertNode(currentNode->left, entity, aabb);
+            if (binCounts[b] > 0)
+            {
+                leftBox = leftSideCount == 0 ? binBoxes[b] : AABB::merge(leftBox, binBoxes[b]);
+                leftSideCount += binCounts[b];
+            }
+            if (leftSideCount == 0 || leftSideCount == count)
+                continue;
+
+            float cost = leftSideCount * leftBox.perimeter() + rightCost[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = b;
+            }
         }
-        else
+
+        if (bestSplit >= 0)
         {
-            insertNode(currentNode->right, entity, aabb);
+            std::int32_t *middle = std::partition(leaves, leaves + count, [&](std::int32_t leaf) {
+                const AABB &box = nodes[leaf].aabb;
+                float centre = splitX ? 0.5f * (box.min.x + box.max.x) : 0.5f * (box.min.y + box.max.y);
+                return std::min(static_cast<int>((centre - axisMin) * binScale), buildBinCount - 1) <= bestSplit;
+            });
+            leftCount = static_cast<std::int32_t>(middle - leaves);
         }
     }
+
+    std::int32_t rightCount = count - leftCount;
+    std::int32_t index = firstInternal;
+    std::int32_t leftFirstInternal = firstInternal + 1;
+    std::int32_t rightFirstInternal = leftFirstInternal + (leftCount - 1);
+
+    std::int32_t left, right;
+    if (jobSystem && leftCount >= parallelBuildCutoff && rightCount >= parallelBuildCutoff)
+    {
+        // the halves split further inside their tasks, the job system spreads them over however many threads it has
+        jobSystem->parallelFor(2, [&](std::size_t side) {
+            if (side == 0)
+                left = buildRange(leaves, leftCount, leftFirstInternal);
+            else
+                right = buildRange(leaves + leftCount, rightCount, rightFirstInternal);
+        });
+    }
+    else
+    {
+        left = buildRange(leaves, leftCount, leftFirstInternal);
+        right = buildRange(leaves + leftCount, rightCount, rightFirstInternal);
+    }
+
+    AABBTreeNode &node = nodes[index];
+    node.left = left;
+    node.right = right;
+    node.aabb = AABB::merge(nodes[left].aabb, nodes[right].aabb);
+    node.height = 1 + std::max(nodes[left].height, nodes[right].height);
+    nodes[left].parent = index;
+    nodes[right].parent = index;
+    mergeFilterBits(index);
+    return index;
 }
 
-void AABBTree::queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+const AABB &AABBTree::getFatAABB(int proxyId) const
+{
+    return nodes[proxyId].aabb;
+}
+
+const std::shared_ptr<Entity> &AABBTree::getEntity(int proxyId) const
+{
+    return entities[proxyId];
+}
+
+void AABBTree::setFilter(int proxyId, const CollisionFilterComponent &filter)
+{
+    setLeafFilter(proxyId, filter);
+
+    // the boxes are unchanged, only the ancestors' bits need refreshing
+    for (std::int32_t index = nodes[proxyId].parent; index != nullNode; index = nodes[index].parent)
+        mergeFilterBits(index);
+}
+
+const CollisionFilterComponent &AABBTree::getFilter(int proxyId) const
+{
+    return filters[proxyId];
+}
+
+void AABBTree::setLeafFilter(std::int32_t leaf, const CollisionFilterComponent &filter)
+{
+    filters[leaf] = filter;
+    FilterBits bits = {filter.categoryBits, filter.maskBits};
+    if (filter.groupIndex > 0)
+        bits.categoryBits = bits.maskBits = 0xFFFF;
+    filterBits[leaf] = bits;
+}
+
+void AABBTree::mergeFilterBits(std::int32_t index)
+{
+    const FilterBits &left = filterBits[nodes[index].left];
+    const FilterBits &right = filterBits[nodes[index].right];
+    FilterBits bits = {static_cast<std::uint16_t>(left.categoryBits | right.categoryBits), static_cast<std::uint16_t>(left.maskBits | right.maskBits)};
+    filterBits[index] = bits;
+}
+
+std::size_t AABBTree::nearest(const Vector2 &point, std::size_t k, int *proxyIds) const
+{
+    return nearest(point, k, proxyIds, [](int) { return true; });
+}
+
+std::size_t AABBTree::getLastQueryNodesVisited() const
+{
+    return lastQueryNodesVisited;
+}
+
+int AABBTree::getNodeCount() const
+{
+    return nodeCount;
+}
+
+void AABBTree::insertLeaf(std::int32_t leaf)
 {
-    if (!root)
+    if (root == nullNode)
+    {
+        root = leaf;
+        nodes[root].parent = nullNode;
         return;
-    queryNode(root, collisions);
+    }
+
+    std::int32_t sibling = findBestSibling(nodes[leaf].aabb);
+    AABB leafAABB = nodes[leaf].aabb;
+
+    // Replace the sibling with a new internal node holding the sibling and the leaf
+    std::int32_t oldParent = nodes[sibling].parent;
+    std::int32_t newParent = allocateNode(); // may grow the pool, so no node references are held across this call
+
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].left = sibling;
+    nodes[newParent].right = leaf;
+    nodes[newParent].aabb = AABB::merge(leafAABB, nodes[sibling].aabb);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+    mergeFilterBits(newParent);
+
+    replaceChild(oldParent, sibling, newParent);
+    refit(newParent);
 }
 
-// recursively traverses teh tree structure to identify and ocllect pairs of entities whose AABBs intesect.
-void AABBTree::queryNode(const std::shared_ptr<AABBTreeNode> &node, std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+void AABBTree::removeLeaf(std::int32_t leaf)
 {
-    if (!node || (!node->left && !node->right))
+    if (leaf == root)
+    {
+        root = nullNode;
         return;
+    }
+
+    // the sibling takes the place of the parent
+    std::int32_t parent = nodes[leaf].parent;
+    std::int32_t grandParent = nodes[parent].parent;
+    std::int32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    nodes[leaf].parent = nullNode;
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    replaceChild(grandParent, parent, sibling);
+    refit(grandParent);
+}
+
+// Branch and bound search for the sibling that minimises the total perimeter ("surface area" in 2D) added to the tree.
+// Pairing the leaf with a node costs the merged perimeter plus the growth of every ancestor (the inherited cost),
+// a subtree is skipped once even a perfect fit below it cannot beat the best cost found so far.
+std::int32_t AABBTree::findBestSibling(const AABB &leafAABB)
+{
+    float leafPerimeter = leafAABB.perimeter();
+
+    std::int32_t bestSibling = root;
+    float bestCost = AABB::merge(nodes[root].aabb, leafAABB).perimeter();
+
+    insertStack.clear();
+    insertStack.push_back(std::make_pair(root, 0.0f));
+    while (!insertStack.empty())
+    {
+        std::int32_t index = insertStack.back().first;
+        float inheritedCost = insertStack.back().second;
+        insertStack.pop_back();
+
+        const AABBTreeNode &node = nodes[index];
+        float directCost = AABB::merge(node.aabb, leafAABB).perimeter();
+        float cost = directCost + inheritedCost;
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSibling = index;
+        }
 
-    if (node->left && node->right)
+        if (node.isLeaf())
+            continue;
+
+        float childInheritedCost = inheritedCost + directCost - node.aabb.perimeter();
+        if (leafPerimeter + childInheritedCost < bestCost)
+        {
+            insertStack.push_back(std::make_pair(node.left, childInheritedCost));
+            insertStack.push_back(std::make_pair(node.right, childInheritedCost));
+        }
+    }
+
+    return bestSibling;
+}
+
+void AABBTree::refit(std::int32_t index)
+{
+    while (index != nullNode)
     {
-        if (node->left->aabb.intersects(node->right->aabb))
+        index = balance(index);
+
+        AABBTreeNode &node = nodes[index];
+        node.aabb = AABB::merge(nodes[node.left].aabb, nodes[node.right].aabb);
+        node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+        mergeFilterBits(index);
+        index = node.parent;
+    }
+}
+
+// AVL style rotation: if one child of node A is more than one level taller than the other, the taller child
+// is lifted into A's place and A takes over the taller child's shorter grandchild. Returns the subtree's new root.
+std::int32_t AABBTree::balance(std::int32_t indexA)
+{
+    AABBTreeNode &A = nodes[indexA];
+    if (A.isLeaf() || A.height < 2)
+        return indexA;
+
+    std::int32_t indexB = A.left;
+    std::int32_t indexC = A.right;
+    AABBTreeNode &B = nodes[indexB];
+    AABBTreeNode &C = nodes[indexC];
+
+    int heightDifference = C.height - B.height;
+
+    // Rotate C up
+    if (heightDifference > 1)
+    {
+        std::int32_t indexF = C.left;
+        std::int32_t indexG = C.right;
+        AABBTreeNode &F = nodes[indexF];
+        AABBTreeNode &G = nodes[indexG];
+
+        C.left = indexA;
+        C.parent = A.parent;
+        A.parent = indexC;
+        replaceChild(C.parent, indexA, indexC);
+
+        if (F.height > G.height)
         {
-            collectLeaves(node->left, node->right, collisions);
+            C.right = indexF;
+            A.right = indexG;
+            G.parent = indexA;
+            A.aabb = AABB::merge(B.aabb, G.aabb);
+            C.aabb = AABB::merge(A.aabb, F.aabb);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
         }
+        else
+        {
+            C.right = indexG;
+            A.right = indexF;
+            F.parent = indexA;
+            A.aabb = AABB::merge(B.aabb, F.aabb);
+            C.aabb = AABB::merge(A.aabb, G.aabb);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        mergeFilterBits(indexA);
+        mergeFilterBits(indexC);
+        rebalanceDemoted(indexA, indexC);
+        return indexC;
+    }
+
+    // Rotate B up
+    if (heightDifference < -1)
+    {
+        std::int32_t indexD = B.left;
+        std::int32_t indexE = B.right;
+        AABBTreeNode &D = nodes[indexD];
+        AABBTreeNode &E = nodes[indexE];
+
+        B.left = indexA;
+        B.parent = A.parent;
+        A.parent = indexB;
+        replaceChild(B.parent, indexA, indexB);
 
-        queryNode(node->left, collisions);
-        queryNode(node->right, collisions);
+        if (D.height > E.height)
+        {
+            B.right = indexD;
+            A.left = indexE;
+            E.parent = indexA;
+            A.aabb = AABB::merge(C.aabb, E.aabb);
+            B.aabb = AABB::merge(A.aabb, D.aabb);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else
+        {
+            B.right = indexE;
+            A.left = indexD;
+            D.parent = indexA;
+            A.aabb = AABB::merge(C.aabb, D.aabb);
+            B.aabb = AABB::merge(A.aabb, E.aabb);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        mergeFilterBits(indexA);
+        mergeFilterBits(indexB);
+        rebalanceDemoted(indexA, indexB);
+        return indexB;
     }
+
+    return indexA;
+}
+
+// After a rotation the demoted node can itself be lopsided (e.g. when many identical boxes keep pairing with the
+// root), so it is rebalanced too and the lifted node's height refreshed.
+void AABBTree::rebalanceDemoted(std::int32_t demoted, std::int32_t lifted)
+{
+    balance(demoted);
+
+    AABBTreeNode &node = nodes[lifted];
+    node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+}
+
+void AABBTree::replaceChild(std::int32_t parent, std::int32_t oldChild, std::int32_t newChild)
+{
+    if (parent == nullNode)
+        root = newChild;
+    else if (nodes[parent].left == oldChild)
+        nodes[parent].left = newChild;
+    else
+        nodes[parent].right = newChild;
+}
+
+int AABBTree::getHeight() const
+{
+    return root == nullNode ? 0 : nodes[root].height;
 }
 
-// helper function that recursively explores two nodes nodeA and ndoeB to collect all pairs of intersecting leaf ndoes
-void AABBTree::collectLeaves(const std::shared_ptr<AABBTreeNode> &nodeA, const std::shared_ptr<AABBTreeNode> &nodeB, std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+int AABBTree::getMaxBalance() const
 {
-    if (!nodeA || !nodeB)
+    int maxBalance = 0;
+    for (const AABBTreeNode &node : nodes)
+    {
+        if (node.height <= 1)
+            continue;
+        int balance = std::abs(nodes[node.right].height - nodes[node.left].height);
+        maxBalance = std::max(maxBalance, balance);
+    }
+    return maxBalance;
+}
+
+float AABBTree::getAreaRatio() const
+{
+    if (root == nullNode)
+        return 0.0f;
+
+    float totalPerimeter = 0.0f;
+    for (const AABBTreeNode &node : nodes)
+    {
+        if (node.height > 0)
+            totalPerimeter += node.aabb.perimeter();
+    }
+    return totalPerimeter / nodes[root].aabb.perimeter();
+}
+
+// trees with fewer leaves are always queried serially
+static const std::int32_t parallelQueryCutoff = 4096;
+// tasks whose subtrees are at most this high run as one unit, larger ones are split further
+static const std::int32_t parallelQueryTaskHeight = 8;
+
+void AABBTree::setJobSystem(JobSystem *system)
+{
+    jobSystem = system;
+}
+
+void AABBTree::queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+{
+    lastQueryNodesVisited = 0;
+    if (root == nullNode)
+        return;
+
+    if (jobSystem && jobSystem->getThreadCount() > 1 && (nodeCount + 1) / 2 >= parallelQueryCutoff)
+    {
+        parallelQuery(collisions);
         return;
+    }
+
+    QueryTask task = {root, root};
+    lastQueryNodesVisited = runQueryTask(task, collisions);
+}
+
+int AABBTree::expandQueryTask(const QueryTask &task, QueryTask children[4], std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+{
+    const AABBTreeNode &nodeA = nodes[task.a];
+    const FilterBits &bitsA = filterBits[task.a];
+
+    // pairs inside one subtree: those inside each child plus those between the two children
+    if (task.a == task.b)
+    {
+        if (nodeA.isLeaf() || (bitsA.maskBits & bitsA.categoryBits) == 0)
+            return 0;
+        children[0] = {nodeA.left, nodeA.left};
+        children[1] = {nodeA.right, nodeA.right};
+        children[2] = {nodeA.left, nodeA.right};
+        return 3;
+    }
+
+    const AABBTreeNode &nodeB = nodes[task.b];
+
+    const FilterBits &bitsB = filterBits[task.b];
 
-    if (nodeA->entity && nodeB->entity)
+    // prune subtrees that cannot contain an overlapping pair, or only pairs their filters rule out
+    if ((bitsA.maskBits & bitsB.categoryBits) == 0 || (bitsB.maskBits & bitsA.categoryBits) == 0 || !nodeA.aabb.intersects(nodeB.aabb))
+        return 0;
+
+    if (nodeA.isLeaf() && nodeB.isLeaf())
     {
-        // Both are leaves
-        collisions.emplace_back(nodeA->entity, nodeB->entity);
+        // Both are leaves, the groups are only checked here
+        if (CollisionFilterComponent::shouldCollide(filters[task.a], filters[task.b]))
+            collisions.emplace_back(entities[task.a], entities[task.b]);
+        return 0;
     }
-    else if (nodeA->entity)
+    if (nodeA.isLeaf())
     {
         // nodeA is leaf, nodeB is internal
-        collectLeaves(nodeA, nodeB->left, collisions);
-        collectLeaves(nodeA, nodeB->right, collisions);
+        children[0] = {task.a, nodeB.left};
+        children[1] = {task.a, nodeB.right};
+        return 2;
     }
-    else if (nodeB->entity)
+    if (nodeB.isLeaf())
     {
         // nodeB is leaf, nodeA is internal
-        collectLeaves(nodeA->left, nodeB, collisions);
-        collectLeaves(nodeA->right, nodeB, collisions);
+        children[0] = {nodeA.left, task.b};
+        children[1] = {nodeA.right, task.b};
+        return 2;
     }
-    else
+
+    // Both are internal
+    children[0] = {nodeA.left, nodeB.left};
+    children[1] = {nodeA.left, nodeB.right};
+    children[2] = {nodeA.right, nodeB.left};
+    children[3] = {nodeA.right, nodeB.right};
+    return 4;
+}
+
+std::size_t AABBTree::runQueryTask(const QueryTask &task, std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+{
+    std::size_t visited = 0;
+    GrowableStack<QueryTask, 256> stack;
+    stack.push(task);
+    while (!stack.empty())
+    {
+        QueryTask children[4];
+        int childCount = expandQueryTask(stack.pop(), children, collisions);
+        ++visited;
+
+        // pushed in reverse so the first child is expanded next
+        for (int i = childCount - 1; i >= 0; --i)
+            stack.push(children[i]);
+    }
+    return visited;
+}
+
+void AABBTree::parallelQuery(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+{
+    // Split the root task until every task is small, pairs met on the way go straight to collisions. The split only
+    // depends on the tree, so the task list is the same for any thread count.
+    queryTasks.clear();
+    GrowableStack<QueryTask, 256> pending;
+    QueryTask rootTask = {root, root};
+    pending.push(rootTask);
+    while (!pending.empty())
+    {
+        QueryTask task = pending.pop();
+        if (std::max(nodes[task.a].height, nodes[task.b].height) <= parallelQueryTaskHeight)
+        {
+            // disjoint pairs would only cost a scheduling round trip
+            if (task.a == task.b || nodes[task.a].aabb.intersects(nodes[task.b].aabb))
+                queryTasks.push_back(task);
+            continue;
+        }
+
+        QueryTask children[4];
+        int childCount = expandQueryTask(task, children, collisions);
+        ++lastQueryNodesVisited;
+        for (int i = childCount - 1; i >= 0; --i)
+            pending.push(children[i]);
+    }
+
+    if (taskPairs.size() < queryTasks.size())
+        taskPairs.resize(queryTasks.size());
+    taskNodesVisited.assign(queryTasks.size(), 0);
+
+    jobSystem->parallelFor(queryTasks.size(), [this](std::size_t i) {
+        taskPairs[i].clear();
+        taskNodesVisited[i] = runQueryTask(queryTasks[i], taskPairs[i]);
+    });
+
+    // concatenate in task order, each task moving its pairs to its own offset in parallel
+    std::size_t offset = collisions.size();
+    taskOffsets.resize(queryTasks.size());
+    for (std::size_t i = 0; i < queryTasks.size(); ++i)
     {
-        // Both are internal
-        collectLeaves(nodeA->left, nodeB->left, collisions);
-        collectLeaves(nodeA->left, nodeB->right, collisions);
-        collectLeaves(nodeA->right, nodeB->left, collisions);
-        collectLeaves(nodeA->right, nodeB->right, collisions);
+        taskOffsets[i] = offset;
+        offset += taskPairs[i].size();
+        lastQueryNodesVisited += taskNodesVisited[i];
     }
+    collisions.resize(offset);
+
+    jobSystem->parallelFor(queryTasks.size(), [this, &collisions](std::size_t i) {
+        std::move(taskPairs[i].begin(), taskPairs[i].end(), collisions.begin() + taskOffsets[i]);
+        taskPairs[i].clear();
+    });
 }
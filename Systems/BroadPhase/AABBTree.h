@@ -2,36 +2,180 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <cstddef>
 #include "../../Entities/Entity.h"
 #include "AABB.h"
+#include "BroadPhase.h"
+#include "GrowableStack.h"
 
 // each node can either be a leaf node containing an entity and an AABB or an internal node that define a region by combining its child notes' bounding boxes
+// Nodes live in one contiguous pool and refer to each other by 32 bit indices, so a traversal walks a single array instead of chasing heap pointers.
 
 class AABBTreeNode
 {
 public:
     AABB aabb; // represents the region covered by this node and its children
 
-    std::shared_ptr<Entity> entity; // points to an entity if leaf else nullptr
-    std::shared_ptr<AABBTreeNode> left;
-    std::shared_ptr<AABBTreeNode> right;
+    std::int32_t parent; // parent index, or the next free node while the node sits on the free list
+    std::int32_t left;   // nullNode for leaves
+    std::int32_t right;
+    std::int32_t height; // 0 for leaves, -1 for free nodes
 
-    AABBTreeNode();
-    AABBTreeNode(const AABB &box, const std::shared_ptr<Entity> &ent = nullptr);
+    bool isLeaf() const { return left == -1; }
 };
 
-class AABBTree
+// The tree is persistent: every entity owns a proxy (a leaf) holding its fat AABB. A proxy is only removed and
+// reinserted once its tight box escapes the fat box, so slow movers cost nothing in the tree from frame to frame.
+// Proxy ids are leaf node indices.
+class AABBTree : public BroadPhase
 {
 public:
-    AABBTree();
+    static const std::int32_t nullNode = -1;
+
+    AABBTree(float fatMargin = 4.0f);
+
+    // inserts a proxy that is never moved, kept for callers that rebuild the tree themselves
     void insert(const std::shared_ptr<Entity> &entity, const AABB &aabb);
-    void queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const;
+
+    int createProxy(const std::shared_ptr<Entity> &entity, const AABB &aabb, const CollisionFilterComponent &filter = CollisionFilterComponent()) override;
+    // returns true if the proxy had to be reinserted
+    bool moveProxy(int proxyId, const AABB &aabb, const Vector2 &displacement = Vector2()) override;
+    void destroyProxy(int proxyId) override;
+    const AABB &getFatAABB(int proxyId) const override;
+    const std::shared_ptr<Entity> &getEntity(int proxyId) const override;
+    void setFilter(int proxyId, const CollisionFilterComponent &filter) override;
+    const CollisionFilterComponent &getFilter(int proxyId) const override;
+
+    // Replaces the whole tree with one built top down over entries using binned surface area heuristic splits,
+    // which is much faster than count sequential inserts and gives a better tree. With a job system, the two halves
+    // of every split above a size cutoff are built as parallel tasks.
+    void build(const BroadPhaseEntry *entries, std::size_t count, std::vector<int> &proxyIds) override;
+
+    // Walks the tree with an explicit stack. With a job system and a large enough tree the walk is cut into
+    // independent subtree (pair) tasks that run in parallel, each into its own buffer, and the buffers are
+    // concatenated in task order, so the result does not depend on the thread count.
+    void queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const override;
+
+    void setJobSystem(JobSystem *jobSystem) override;
+
+    // Spatial queries over the proxies' fat AABBs, for gameplay code asking what is in a region, under a point,
+    // along a ray or close by. They walk the tree on a GrowableStack and hand proxy ids (see getEntity and
+    // getFilter) to a visitor; nothing is allocated unless the tree is unusually deep. The visitor must not
+    // modify the tree. Fat boxes are larger than the shapes, so a visitor wanting exact answers tests the shape.
+
+    // visitor(int proxyId) -> bool for every proxy whose box overlaps aabb, return false to stop the query
+    template <typename Visitor>
+    void queryAABB(const AABB &aabb, Visitor &&visitor) const;
+
+    // visitor(int proxyId) -> bool for every proxy whose box contains point, return false to stop the query
+    template <typename Visitor>
+    void queryPoint(const Vector2 &point, Visitor &&visitor) const;
+
+    // the segment origin + t * translation for t in [0, maxFraction]
+    struct RayCastInput
+    {
+        Vector2 origin;
+        Vector2 translation;
+        float maxFraction;
+    };
+
+    // visitor(const RayCastInput &input, int proxyId) -> float for the proxies whose box the ray enters, the
+    // child box the ray enters first is always visited first. As in Box2D the return value steers the cast: a
+    // negative value ignores the proxy, 0 stops, and a fraction clips the ray there, so boxes beyond the closest
+    // hit so far are skipped (return input.maxFraction to go on unchanged). input.maxFraction is the current,
+    // possibly clipped, length.
+    template <typename Visitor>
+    void rayCast(const RayCastInput &input, Visitor &&visitor) const;
+
+    // Writes the up to k proxies whose boxes are nearest to point (distance 0 if a box contains it) to proxyIds,
+    // closest first, and returns how many were found. accept(int proxyId) -> bool may skip proxies, e.g. the
+    // entity asking. proxyIds must hold k entries.
+    template <typename Accept>
+    std::size_t nearest(const Vector2 &point, std::size_t k, int *proxyIds, Accept &&accept) const;
+    std::size_t nearest(const Vector2 &point, std::size_t k, int *proxyIds) const;
+
+    // number of nodes (and node pairs) touched by the last queryPotentialCollisions call
+    std::size_t getLastQueryNodesVisited() const override;
+    // number of nodes in use, leaves and internal nodes
+    int getNodeCount() const;
+
+    // Quality metrics: height of the root (leaves are 0), the largest height difference between two siblings
+    // (rotations keep it small regardless of insertion order), and the summed perimeter of all internal nodes
+    // relative to the root's, which is proportional to the expected cost of a query
+    int getHeight() const override;
+    int getMaxBalance() const;
+    float getAreaRatio() const;
 
 private:
-    std::shared_ptr<AABBTreeNode> root;
+    std::vector<AABBTreeNode> nodes;
+    std::vector<std::shared_ptr<Entity>> entities; // indexed like nodes, only set for leaves
+    std::vector<CollisionFilterComponent> filters;  // indexed like nodes, only set for leaves
+
+    // Category and mask bits of every node: a leaf's own (all bits for a leaf in a positive group, which collides
+    // whatever the masks say), an internal node's the OR of its children's, so the query skips a pair of subtrees
+    // whose bits rule out every leaf pair between them. Kept apart from the nodes so those stay 32 bytes.
+    struct FilterBits
+    {
+        std::uint16_t categoryBits;
+        std::uint16_t maskBits;
+    };
+    std::vector<FilterBits> filterBits;
+    std::int32_t root;
+    std::int32_t freeList;
+    int nodeCount;
+    mutable std::size_t lastQueryNodesVisited;
+
+    // scratch stack for findBestSibling, kept to avoid an allocation per insert
+    std::vector<std::pair<std::int32_t, float>> insertStack;
+
+    // Unit of the self query: all overlapping leaf pairs between subtrees a and b, or inside subtree a if a == b
+    struct QueryTask
+    {
+        std::int32_t a;
+        std::int32_t b;
+    };
+
+    JobSystem *jobSystem;
+    // per task results of the parallel query, kept to reuse their buffers
+    mutable std::vector<QueryTask> queryTasks;
+    mutable std::vector<std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>>> taskPairs;
+    mutable std::vector<std::size_t> taskNodesVisited;
+    mutable std::vector<std::size_t> taskOffsets;
 
-    // recursivelt finds the correct position in the tree
-    void insertNode(std::shared_ptr<AABBTreeNode> &currentNode, const std::shared_ptr<Entity> &entity, const AABB &aabb);
-    void queryNode(const std::shared_ptr<AABBTreeNode> &node, std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const;
-    void collectLeaves(const std::shared_ptr<AABBTreeNode> &nodeA, const std::shared_ptr<AABBTreeNode> &nodeB, std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const;
+    void growPool(int capacity);
+    std::int32_t allocateNode();
+    void freeNode(std::int32_t index);
+
+    void insertLeaf(std::int32_t leaf);
+    void removeLeaf(std::int32_t leaf);
+    std::int32_t buildRange(std::int32_t *leaves, std::int32_t count, std::int32_t firstInternal);
+    std::int32_t findBestSibling(const AABB &leafAABB);
+    // recomputes boxes and heights from index up to the root, rebalancing on the way
+    void refit(std::int32_t index);
+    std::int32_t balance(std::int32_t index);
+    void rebalanceDemoted(std::int32_t demoted, std::int32_t lifted);
+    void replaceChild(std::int32_t parent, std::int32_t oldChild, std::int32_t newChild);
+    void setLeafFilter(std::int32_t leaf, const CollisionFilterComponent &filter);
+    void mergeFilterBits(std::int32_t index);
+
+    // one traversal step: reports task's pair if it is a leaf pair, otherwise writes the sub tasks to children
+    // and returns their count
+    int expandQueryTask(const QueryTask &task, QueryTask children[4], std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const;
+    // runs task to completion on an explicit stack, returns the number of tasks visited
+    std::size_t runQueryTask(const QueryTask &task, std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const;
+    void parallelQuery(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const;
+
+    // stack entry of rayCast and nearest, a node with its ray entry fraction or its squared distance
+    struct SearchEntry
+    {
+        std::int32_t index;
+        float key;
+    };
+
+    // slab test, the fraction at which the segment enters box or a negative value if it misses
+    static float rayEntry(const RayCastInput &input, const AABB &box);
+    static float distanceSquared(const Vector2 &point, const AABB &box);
 };
+
+#include "AABBTree.inl"
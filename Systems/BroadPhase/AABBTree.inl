@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+template <typename Visitor>
+void AABBTree::queryAABB(const AABB &aabb, Visitor &&visitor) const
+{
+    if (root == nullNode)
+        return;
+
+    GrowableStack<std::int32_t, 256> stack;
+    stack.push(root);
+    while (!stack.empty())
+    {
+        std::int32_t index = stack.pop();
+        const AABBTreeNode &node = nodes[index];
+        if (!node.aabb.intersects(aabb))
+            continue;
+
+        if (node.isLeaf())
+        {
+            if (!visitor(static_cast<int>(index)))
+                return;
+        }
+        else
+        {
+            stack.push(node.right);
+            stack.push(node.left);
+        }
+    }
+}
+
+template <typename Visitor>
+void AABBTree::queryPoint(const Vector2 &point, Visitor &&visitor) const
+{
+    queryAABB(AABB(point, point), visitor);
+}
+
+template <typename Visitor>
+void AABBTree::rayCast(const RayCastInput &input, Visitor &&visitor) const
+{
+    if (root == nullNode)
+        return;
+
+    RayCastInput ray = input;
+    SearchEntry first = {root, rayEntry(ray, nodes[root].aabb)};
+    if (first.key < 0.0f)
+        return;
+
+    // entries keep the fraction at which the ray enters them, those beyond a closer hit found since are dropped
+    GrowableStack<SearchEntry, 256> stack;
+    stack.push(first);
+    while (!stack.empty())
+    {
+        SearchEntry entry = stack.pop();
+        if (entry.key > ray.maxFraction)
+            continue;
+
+        const AABBTreeNode &node = nodes[entry.index];
+        if (node.isLeaf())
+        {
+            float value = visitor(static_cast<const RayCastInput &>(ray), static_cast<int>(entry.index));
+            if (value == 0.0f)
+                return;
+            if (value > 0.0f && value < ray.maxFraction)
+                ray.maxFraction = value;
+            continue;
+        }
+
+        SearchEntry left = {node.left, rayEntry(ray, nodes[node.left].aabb)};
+        SearchEntry right = {node.right, rayEntry(ray, nodes[node.right].aabb)};
+        if (left.key >= 0.0f && right.key >= 0.0f)
+        {
+            // the nearer child goes on top, its hits may clip the ray before the other one is reached
+            stack.push(left.key <= right.key ? right : left);
+            stack.push(left.key <= right.key ? left : right);
+        }
+        else if (left.key >= 0.0f)
+        {
+            stack.push(left);
+        }
+        else if (right.key >= 0.0f)
+        {
+            stack.push(right);
+        }
+    }
+}
+
+// Depth first branch and bound: proxyIds holds the best proxies found so far in order, and once it holds k a node
+// no nearer than the last of them cannot improve it.
+template <typename Accept>
+std::size_t AABBTree::nearest(const Vector2 &point, std::size_t k, int *proxyIds, Accept &&accept) const
+{
+    if (root == nullNode || k == 0)
+        return 0;
+
+    std::size_t found = 0;
+    float worst = FLT_MAX; // squared distance of proxyIds[k - 1] once k were found
+    GrowableStack<SearchEntry, 256> stack;
+    SearchEntry first = {root, distanceSquared(point, nodes[root].aabb)};
+    stack.push(first);
+    while (!stack.empty())
+    {
+        SearchEntry entry = stack.pop();
+        if (found == k && entry.key >= worst)
+            continue;
+
+        const AABBTreeNode &node = nodes[entry.index];
+        if (node.isLeaf())
+        {
+            if (!accept(static_cast<int>(entry.index)))
+                continue;
+
+            // insertion into the sorted list, the last one drops out when it is full
+            std::size_t position = found < k ? found++ : k - 1;
+            while (position > 0 && distanceSquared(point, nodes[proxyIds[position - 1]].aabb) > entry.key)
+            {
+                proxyIds[position] = proxyIds[position - 1];
+                --position;
+            }
+            proxyIds[position] = static_cast<int>(entry.index);
+            if (found == k)
+                worst = distanceSquared(point, nodes[proxyIds[k - 1]].aabb);
+            continue;
+        }
+
+        SearchEntry left = {node.left, distanceSquared(point, nodes[node.left].aabb)};
+        SearchEntry right = {node.right, distanceSquared(point, nodes[node.right].aabb)};
+        stack.push(left.key <= right.key ? right : left);
+        stack.push(left.key <= right.key ? left : right);
+    }
+    return found;
+}
+
+inline float AABBTree::rayEntry(const RayCastInput &input, const AABB &box)
+{
+    const float origin[2] = {input.origin.x, input.origin.y};
+    const float translation[2] = {input.translation.x, input.translation.y};
+    const float boxMin[2] = {box.min.x, box.min.y};
+    const float boxMax[2] = {box.max.x, box.max.y};
+
+    float entry = 0.0f;
+    float exit = input.maxFraction;
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if (std::abs(translation[axis]) < FLT_EPSILON)
+        {
+            // parallel to the slab, the ray is inside it everywhere or nowhere
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+                return -1.0f;
+            continue;
+        }
+
+        float inverse = 1.0f / translation[axis];
+        float slabEntry = (boxMin[axis] - origin[axis]) * inverse;
+        float slabExit = (boxMax[axis] - origin[axis]) * inverse;
+        if (slabEntry > slabExit)
+            std::swap(slabEntry, slabExit);
+        entry = std::max(entry, slabEntry);
+        exit = std::min(exit, slabExit);
+        if (entry > exit)
+            return -1.0f;
+    }
+    return entry;
+}
+
+inline float AABBTree::distanceSquared(const Vector2 &point, const AABB &box)
+{
+    float dx = std::max(std::max(box.min.x - point.x, point.x - box.max.x), 0.0f);
+    float dy = std::max(std::max(box.min.y - point.y, point.y - box.max.y), 0.0f);
+    return dx * dx + dy * dy;
+}
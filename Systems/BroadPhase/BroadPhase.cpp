@@ -0,0 +1,37 @@
+#include "BroadPhase.h"
+
+// how far ahead of the current displacement the fat box is stretched
+static const float displacementMultiplier = 4.0f;
+
+BroadPhase::BroadPhase(float fatMargin) : fatMargin(fatMargin) {}
+
+AABB BroadPhase::fatten(const AABB &aabb, const Vector2 &displacement) const
+{
+    AABB fat(Vector2(aabb.min.x - fatMargin, aabb.min.y - fatMargin),
+             Vector2(aabb.max.x + fatMargin, aabb.max.y + fatMargin));
+
+    // stretch the box in the direction of travel so it survives a few more frames
+    Vector2 d = displacement * displacementMultiplier;
+    if (d.x < 0.0f)
+        fat.min.x += d.x;
+    else
+        fat.max.x += d.x;
+    if (d.y < 0.0f)
+        fat.min.y += d.y;
+    else
+        fat.max.y += d.y;
+
+    return fat;
+}
+
+bool BroadPhase::fatAABBStillValid(const AABB &fatAABB, const AABB &aabb, const AABB &newFatAABB) const
+{
+    if (!fatAABB.contains(aabb))
+        return false;
+
+    // a box stretched for a fast mover that has since slowed down is refreshed, measured against the box it would
+    // get now so one still moving as fast keeps its current one
+    float grow = displacementMultiplier * fatMargin;
+    AABB huge(Vector2(newFatAABB.min.x - grow, newFatAABB.min.y - grow), Vector2(newFatAABB.max.x + grow, newFatAABB.max.y + grow));
+    return huge.contains(fatAABB);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include "../../Entities/Entity.h"
+#include "../../Components/CollisionFilterComponent.h"
+#include "AABB.h"
+
+class JobSystem;
+
+enum class BroadPhaseType
+{
+    AABBTree,
+    SweepAndPrune,
+    SpatialHashGrid
+};
+
+// one input item for BroadPhase::build
+struct BroadPhaseEntry
+{
+    std::shared_ptr<Entity> entity;
+    AABB aabb;
+    CollisionFilterComponent filter;
+};
+
+// Common interface of the broad phase implementations. Every entity owns a proxy whose box is a "fat" AABB, the
+// tight box grown by a margin and by the predicted displacement. A proxy's fat box only changes once the tight box
+// escapes it, and all implementations use the same rule, so for the same sequence of calls they report the same
+// set of pairs (each pair once, in no particular order or orientation). Pairs whose filters rule them out
+// (CollisionFilterComponent::shouldCollide) are never reported.
+class BroadPhase
+{
+public:
+    BroadPhase(float fatMargin);
+    virtual ~BroadPhase() {}
+
+    // returns a proxy id that stays valid until destroyProxy
+    virtual int createProxy(const std::shared_ptr<Entity> &entity, const AABB &aabb, const CollisionFilterComponent &filter = CollisionFilterComponent()) = 0;
+    // returns true if the proxy's fat box had to be recomputed
+    virtual bool moveProxy(int proxyId, const AABB &aabb, const Vector2 &displacement = Vector2()) = 0;
+    virtual void destroyProxy(int proxyId) = 0;
+    virtual const AABB &getFatAABB(int proxyId) const = 0;
+    virtual const std::shared_ptr<Entity> &getEntity(int proxyId) const = 0;
+    virtual void setFilter(int proxyId, const CollisionFilterComponent &filter) = 0;
+    virtual const CollisionFilterComponent &getFilter(int proxyId) const = 0;
+
+    // Replaces every proxy with the given entries, proxyIds[i] receives the proxy of entries[i].
+    virtual void build(const BroadPhaseEntry *entries, std::size_t count, std::vector<int> &proxyIds) = 0;
+
+    // reports every pair of proxies whose fat AABBs overlap and whose filters let them collide
+    virtual void queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const = 0;
+
+    // diagnostics, implementations without a tree report a height of 0, those that do not count visited nodes 0
+    virtual int getHeight() const { return 0; }
+    virtual std::size_t getLastQueryNodesVisited() const { return 0; }
+
+    // job system an implementation may spread build and queryPotentialCollisions over, nullptr (the default) keeps them serial
+    virtual void setJobSystem(JobSystem *jobSystem) { (void)jobSystem; }
+
+protected:
+    float fatMargin;
+
+    AABB fatten(const AABB &aabb, const Vector2 &displacement) const;
+    // true while aabb is inside fatAABB and fatAABB is not far larger than newFatAABB, the box fatten would give now
+    bool fatAABBStillValid(const AABB &fatAABB, const AABB &aabb, const AABB &newFatAABB) const;
+};
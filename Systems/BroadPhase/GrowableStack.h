@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+// Stack for tree traversals that lives on the call stack for the first N entries and only moves to the heap when a
+// traversal goes deeper, so queries neither recurse nor allocate in the common case.
+template <typename T, int N>
+class GrowableStack
+{
+public:
+    GrowableStack() : stack(array), count(0), capacity(N) {}
+
+    GrowableStack(const GrowableStack &) = delete;
+    GrowableStack &operator=(const GrowableStack &) = delete;
+
+    void push(const T &element)
+    {
+        if (count == capacity)
+        {
+            // the first spill copies the inline entries, later ones already live in heap and resize keeps them
+            if (stack == array)
+                heap.assign(array, array + count);
+            heap.resize(capacity * 2);
+            stack = heap.data();
+            capacity *= 2;
+        }
+        stack[count++] = element;
+    }
+
+    T pop()
+    {
+        return stack[--count];
+    }
+
+    bool empty() const { return count == 0; }
+    int getCount() const { return count; }
+
+private:
+    T *stack;
+    T array[N];
+    std::vector<T> heap;
+    int count;
+    int capacity;
+};
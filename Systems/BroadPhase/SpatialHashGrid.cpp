@@ -0,0 +1,195 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHashGrid::SpatialHashGrid(float cellSize, float fatMargin)
+    : BroadPhase(fatMargin), cellSize(cellSize), inverseCellSize(1.0f / cellSize) {}
+
+int SpatialHashGrid::createProxy(const std::shared_ptr<Entity> &entity, const AABB &aabb, const CollisionFilterComponent &filter)
+{
+    int proxyId;
+    if (!freeProxies.empty())
+    {
+        proxyId = freeProxies.back();
+        freeProxies.pop_back();
+    }
+    else
+    {
+        proxyId = static_cast<int>(proxies.size());
+        proxies.push_back(Proxy());
+    }
+
+    proxies[proxyId].aabb = fatten(aabb, Vector2());
+    proxies[proxyId].filter = filter;
+    proxies[proxyId].entity = entity;
+    return proxyId;
+}
+
+bool SpatialHashGrid::moveProxy(int proxyId, const AABB &aabb, const Vector2 &displacement)
+{
+    AABB fatAABB = fatten(aabb, displacement);
+    if (fatAABBStillValid(proxies[proxyId].aabb, aabb, fatAABB))
+        return false;
+
+    proxies[proxyId].aabb = fatAABB;
+    return true;
+}
+
+void SpatialHashGrid::destroyProxy(int proxyId)
+{
+    proxies[proxyId].entity.reset();
+    freeProxies.push_back(proxyId);
+}
+
+const AABB &SpatialHashGrid::getFatAABB(int proxyId) const
+{
+    return proxies[proxyId].aabb;
+}
+
+const std::shared_ptr<Entity> &SpatialHashGrid::getEntity(int proxyId) const
+{
+    return proxies[proxyId].entity;
+}
+
+void SpatialHashGrid::setFilter(int proxyId, const CollisionFilterComponent &filter)
+{
+    proxies[proxyId].filter = filter;
+}
+
+const CollisionFilterComponent &SpatialHashGrid::getFilter(int proxyId) const
+{
+    return proxies[proxyId].filter;
+}
+
+void SpatialHashGrid::build(const BroadPhaseEntry *entries, std::size_t count, std::vector<int> &proxyIds)
+{
+    proxies.clear();
+    freeProxies.clear();
+    proxies.reserve(count);
+
+    proxyIds.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        proxyIds[i] = createProxy(entries[i].entity, entries[i].aabb, entries[i].filter);
+    }
+}
+
+float SpatialHashGrid::getCellSize() const
+{
+    return cellSize;
+}
+
+std::int32_t SpatialHashGrid::cellCoordinate(float value) const
+{
+    return static_cast<std::int32_t>(std::floor(value * inverseCellSize));
+}
+
+// linear probing, the table is kept at most half full
+std::uint32_t SpatialHashGrid::findSlot(std::int32_t x, std::int32_t y) const
+{
+    std::uint32_t mask = static_cast<std::uint32_t>(cells.size()) - 1;
+    std::uint32_t slot = (static_cast<std::uint32_t>(x) * 73856093u ^ static_cast<std::uint32_t>(y) * 19349663u) & mask;
+    while (cells[slot].count != 0 && (cells[slot].x != x || cells[slot].y != y))
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void SpatialHashGrid::queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+{
+    // Size the table for the number of (proxy, cell) entries
+    std::size_t entryCount = 0;
+    for (const Proxy &proxy : proxies)
+    {
+        if (!proxy.entity)
+            continue;
+        std::size_t columns = cellCoordinate(proxy.aabb.max.x) - cellCoordinate(proxy.aabb.min.x) + 1;
+        std::size_t rows = cellCoordinate(proxy.aabb.max.y) - cellCoordinate(proxy.aabb.min.y) + 1;
+        entryCount += columns * rows;
+    }
+
+    std::size_t tableSize = 16;
+    while (tableSize < 2 * entryCount)
+        tableSize *= 2;
+    Cell emptyCell = {0, 0, 0, 0};
+    cells.assign(tableSize, emptyCell);
+    entrySlots.resize(entryCount);
+    cellEntries.resize(entryCount);
+    occupiedSlots.clear();
+
+    // Pass 1: count the proxies of every cell
+    std::size_t entry = 0;
+    for (const Proxy &proxy : proxies)
+    {
+        if (!proxy.entity)
+            continue;
+        std::int32_t x0 = cellCoordinate(proxy.aabb.min.x), x1 = cellCoordinate(proxy.aabb.max.x);
+        std::int32_t y0 = cellCoordinate(proxy.aabb.min.y), y1 = cellCoordinate(proxy.aabb.max.y);
+        for (std::int32_t y = y0; y <= y1; ++y)
+        {
+            for (std::int32_t x = x0; x <= x1; ++x)
+            {
+                std::uint32_t slot = findSlot(x, y);
+                Cell &cell = cells[slot];
+                if (cell.count == 0)
+                {
+                    cell.x = x;
+                    cell.y = y;
+                    occupiedSlots.push_back(slot);
+                }
+                ++cell.count;
+                entrySlots[entry++] = slot;
+            }
+        }
+    }
+
+    // Prefix sum gives every cell its range in cellEntries
+    std::uint32_t offset = 0;
+    for (std::uint32_t slot : occupiedSlots)
+    {
+        cells[slot].start = offset;
+        offset += cells[slot].count;
+        cells[slot].count = 0; // reused as the fill cursor below
+    }
+
+    // Pass 2: scatter proxy ids, the entries come in the same order as in pass 1
+    entry = 0;
+    for (std::size_t proxyId = 0; proxyId < proxies.size(); ++proxyId)
+    {
+        const Proxy &proxy = proxies[proxyId];
+        if (!proxy.entity)
+            continue;
+        std::size_t columns = cellCoordinate(proxy.aabb.max.x) - cellCoordinate(proxy.aabb.min.x) + 1;
+        std::size_t rows = cellCoordinate(proxy.aabb.max.y) - cellCoordinate(proxy.aabb.min.y) + 1;
+        for (std::size_t i = 0; i < columns * rows; ++i)
+        {
+            Cell &cell = cells[entrySlots[entry++]];
+            cellEntries[cell.start + cell.count++] = static_cast<std::int32_t>(proxyId);
+        }
+    }
+
+    // Test every pair within a cell, reporting it only from the cell that holds the min corner of the overlap
+    for (std::uint32_t slot : occupiedSlots)
+    {
+        const Cell &cell = cells[slot];
+        const std::int32_t *members = &cellEntries[cell.start];
+        for (std::uint32_t i = 0; i < cell.count; ++i)
+        {
+            const Proxy &proxyA = proxies[members[i]];
+            for (std::uint32_t j = i + 1; j < cell.count; ++j)
+            {
+                const Proxy &proxyB = proxies[members[j]];
+                if (!proxyA.aabb.intersects(proxyB.aabb) || !CollisionFilterComponent::shouldCollide(proxyA.filter, proxyB.filter))
+                    continue;
+
+                float overlapMinX = std::max(proxyA.aabb.min.x, proxyB.aabb.min.x);
+                float overlapMinY = std::max(proxyA.aabb.min.y, proxyB.aabb.min.y);
+                if (cellCoordinate(overlapMinX) == cell.x && cellCoordinate(overlapMinY) == cell.y)
+                {
+                    collisions.emplace_back(proxyA.entity, proxyB.entity);
+                }
+            }
+        }
+    }
+}
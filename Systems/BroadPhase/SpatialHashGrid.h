@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "BroadPhase.h"
+
+// Uniform grid broad phase for scenes of similarly sized bodies. Each query bins every fat box into the cells it
+// covers: the cells are counted in an open addressed hash table, turned into offsets with a prefix sum and the
+// proxies scattered into one flat array (a counting sort), so nothing is allocated once the buffers have grown.
+// A pair that shares several cells is only reported by the cell holding the min corner of the two boxes' overlap.
+// cellSize should be about the size of the largest body, bigger boxes still work but cover many cells.
+class SpatialHashGrid : public BroadPhase
+{
+public:
+    SpatialHashGrid(float cellSize = 64.0f, float fatMargin = 4.0f);
+
+    int createProxy(const std::shared_ptr<Entity> &entity, const AABB &aabb, const CollisionFilterComponent &filter = CollisionFilterComponent()) override;
+    bool moveProxy(int proxyId, const AABB &aabb, const Vector2 &displacement = Vector2()) override;
+    void destroyProxy(int proxyId) override;
+    const AABB &getFatAABB(int proxyId) const override;
+    const std::shared_ptr<Entity> &getEntity(int proxyId) const override;
+    void setFilter(int proxyId, const CollisionFilterComponent &filter) override;
+    const CollisionFilterComponent &getFilter(int proxyId) const override;
+
+    void build(const BroadPhaseEntry *entries, std::size_t count, std::vector<int> &proxyIds) override;
+
+    void queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const override;
+
+    float getCellSize() const;
+
+private:
+    struct Proxy
+    {
+        AABB aabb;
+        CollisionFilterComponent filter;
+        std::shared_ptr<Entity> entity; // nullptr while the proxy id is free
+    };
+
+    struct Cell
+    {
+        std::int32_t x;
+        std::int32_t y;
+        std::uint32_t count; // 0 marks an empty slot
+        std::uint32_t start; // offset into cellEntries
+    };
+
+    float cellSize;
+    float inverseCellSize;
+    std::vector<Proxy> proxies;
+    std::vector<int> freeProxies;
+
+    // rebuilt by every query, kept to reuse their storage
+    mutable std::vector<Cell> cells;
+    mutable std::vector<std::uint32_t> entrySlots;    // cell slot of every (proxy, covered cell) entry, in proxy order
+    mutable std::vector<std::int32_t> cellEntries;    // proxy ids grouped by cell
+    mutable std::vector<std::uint32_t> occupiedSlots; // slots with count > 0, in first use order
+
+    std::int32_t cellCoordinate(float value) const;
+    std::uint32_t findSlot(std::int32_t x, std::int32_t y) const;
+};
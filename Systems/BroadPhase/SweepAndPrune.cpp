@@ -0,0 +1,199 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+SweepAndPrune::SweepAndPrune(float fatMargin) : BroadPhase(fatMargin), sortedEndpoints(0), sweepAxis(0) {}
+
+int SweepAndPrune::createProxy(const std::shared_ptr<Entity> &entity, const AABB &aabb, const CollisionFilterComponent &filter)
+{
+    int proxyId;
+    if (!freeProxies.empty())
+    {
+        proxyId = freeProxies.back();
+        freeProxies.pop_back();
+    }
+    else
+    {
+        proxyId = static_cast<int>(proxies.size());
+        proxies.push_back(Proxy());
+    }
+
+    proxies[proxyId].aabb = fatten(aabb, Vector2());
+    proxies[proxyId].filter = filter;
+    proxies[proxyId].entity = entity;
+
+    // values are refreshed before every sort, new endpoints wait at the back until the next one
+    Endpoint minPoint = {0.0f, proxyId, 0};
+    Endpoint maxPoint = {0.0f, proxyId, 1};
+    endpoints.push_back(minPoint);
+    endpoints.push_back(maxPoint);
+    return proxyId;
+}
+
+bool SweepAndPrune::moveProxy(int proxyId, const AABB &aabb, const Vector2 &displacement)
+{
+    AABB fatAABB = fatten(aabb, displacement);
+    if (fatAABBStillValid(proxies[proxyId].aabb, aabb, fatAABB))
+        return false;
+
+    proxies[proxyId].aabb = fatAABB;
+    return true;
+}
+
+void SweepAndPrune::destroyProxy(int proxyId)
+{
+    auto ofProxy = [proxyId](const Endpoint &endpoint) { return endpoint.proxyId == proxyId; };
+    sortedEndpoints -= std::count_if(endpoints.begin(), endpoints.begin() + sortedEndpoints, ofProxy);
+    endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), ofProxy), endpoints.end());
+
+    proxies[proxyId].entity.reset();
+    freeProxies.push_back(proxyId);
+}
+
+const AABB &SweepAndPrune::getFatAABB(int proxyId) const
+{
+    return proxies[proxyId].aabb;
+}
+
+const std::shared_ptr<Entity> &SweepAndPrune::getEntity(int proxyId) const
+{
+    return proxies[proxyId].entity;
+}
+
+void SweepAndPrune::setFilter(int proxyId, const CollisionFilterComponent &filter)
+{
+    proxies[proxyId].filter = filter;
+}
+
+const CollisionFilterComponent &SweepAndPrune::getFilter(int proxyId) const
+{
+    return proxies[proxyId].filter;
+}
+
+void SweepAndPrune::build(const BroadPhaseEntry *entries, std::size_t count, std::vector<int> &proxyIds)
+{
+    proxies.clear();
+    freeProxies.clear();
+    endpoints.clear();
+    proxies.reserve(count);
+    endpoints.reserve(2 * count);
+
+    proxyIds.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        proxyIds[i] = createProxy(entries[i].entity, entries[i].aabb, entries[i].filter);
+    }
+
+    // the next query would otherwise insertion sort an unsorted array
+    sweepAxis = chooseSweepAxis();
+    for (Endpoint &endpoint : endpoints)
+    {
+        const AABB &box = proxies[endpoint.proxyId].aabb;
+        const Vector2 &corner = endpoint.isMax ? box.max : box.min;
+        endpoint.value = sweepAxis == 0 ? corner.x : corner.y;
+    }
+    std::sort(endpoints.begin(), endpoints.end(), endpointLess);
+    sortedEndpoints = endpoints.size();
+}
+
+int SweepAndPrune::getSweepAxis() const
+{
+    return sweepAxis;
+}
+
+bool SweepAndPrune::endpointLess(const Endpoint &a, const Endpoint &b)
+{
+    return a.value < b.value || (a.value == b.value && a.isMax < b.isMax);
+}
+
+// the axis along which the fat box centres have the larger variance separates the most boxes
+int SweepAndPrune::chooseSweepAxis() const
+{
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumYY = 0.0;
+    std::size_t count = 0;
+    for (const Endpoint &endpoint : endpoints)
+    {
+        if (endpoint.isMax)
+            continue;
+
+        const AABB &box = proxies[endpoint.proxyId].aabb;
+        double cx = 0.5 * (box.min.x + box.max.x);
+        double cy = 0.5 * (box.min.y + box.max.y);
+        sumX += cx;
+        sumY += cy;
+        sumXX += cx * cx;
+        sumYY += cy * cy;
+        ++count;
+    }
+
+    if (count == 0)
+        return sweepAxis;
+
+    double varianceX = sumXX / count - (sumX / count) * (sumX / count);
+    double varianceY = sumYY / count - (sumY / count) * (sumY / count);
+    return varianceY > varianceX ? 1 : 0;
+}
+
+void SweepAndPrune::queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const
+{
+    int axis = chooseSweepAxis();
+    bool axisChanged = axis != sweepAxis;
+    sweepAxis = axis;
+
+    for (Endpoint &endpoint : endpoints)
+    {
+        const AABB &box = proxies[endpoint.proxyId].aabb;
+        const Vector2 &corner = endpoint.isMax ? box.max : box.min;
+        endpoint.value = axis == 0 ? corner.x : corner.y;
+    }
+
+    if (axisChanged)
+    {
+        std::sort(endpoints.begin(), endpoints.end(), endpointLess);
+    }
+    else
+    {
+        // insertion sort of the endpoints sorted last time, linear when only a few swapped places since
+        for (std::size_t i = 1; i < sortedEndpoints; ++i)
+        {
+            Endpoint key = endpoints[i];
+            std::size_t j = i;
+            while (j > 0 && endpointLess(key, endpoints[j - 1]))
+            {
+                endpoints[j] = endpoints[j - 1];
+                --j;
+            }
+            endpoints[j] = key;
+        }
+
+        // a burst of new proxies would make that quadratic, so they are sorted apart and merged in
+        if (sortedEndpoints < endpoints.size())
+        {
+            std::sort(endpoints.begin() + sortedEndpoints, endpoints.end(), endpointLess);
+            std::inplace_merge(endpoints.begin(), endpoints.begin() + sortedEndpoints, endpoints.end(), endpointLess);
+        }
+    }
+    sortedEndpoints = endpoints.size();
+
+    // Sweep: a box overlaps, along the sweep axis, every box still open when its min endpoint is reached
+    activeProxies.clear();
+    for (const Endpoint &endpoint : endpoints)
+    {
+        if (endpoint.isMax)
+        {
+            auto it = std::find(activeProxies.begin(), activeProxies.end(), endpoint.proxyId);
+            *it = activeProxies.back();
+            activeProxies.pop_back();
+            continue;
+        }
+
+        const Proxy &proxy = proxies[endpoint.proxyId];
+        for (std::int32_t other : activeProxies)
+        {
+            if (proxy.aabb.intersects(proxies[other].aabb) && CollisionFilterComponent::shouldCollide(proxy.filter, proxies[other].filter))
+            {
+                collisions.emplace_back(proxies[other].entity, proxy.entity);
+            }
+        }
+        activeProxies.push_back(endpoint.proxyId);
+    }
+}
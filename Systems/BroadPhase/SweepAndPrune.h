@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "BroadPhase.h"
+
+// Sort and sweep broad phase. The min/max endpoints of every fat AABB along one axis are kept in a persistent
+// array that is re-sorted with insertion sort each query. Bodies barely move between frames, so the array is
+// almost sorted and the sort is close to linear. Endpoints of proxies created since the last query are sorted on
+// their own and merged in. The sweep axis is the one along which the box centres vary most.
+class SweepAndPrune : public BroadPhase
+{
+public:
+    SweepAndPrune(float fatMargin = 4.0f);
+
+    int createProxy(const std::shared_ptr<Entity> &entity, const AABB &aabb, const CollisionFilterComponent &filter = CollisionFilterComponent()) override;
+    bool moveProxy(int proxyId, const AABB &aabb, const Vector2 &displacement = Vector2()) override;
+    void destroyProxy(int proxyId) override;
+    const AABB &getFatAABB(int proxyId) const override;
+    const std::shared_ptr<Entity> &getEntity(int proxyId) const override;
+    void setFilter(int proxyId, const CollisionFilterComponent &filter) override;
+    const CollisionFilterComponent &getFilter(int proxyId) const override;
+
+    void build(const BroadPhaseEntry *entries, std::size_t count, std::vector<int> &proxyIds) override;
+
+    void queryPotentialCollisions(std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions) const override;
+
+    // 0 for x, 1 for y, the axis used by the last query
+    int getSweepAxis() const;
+
+private:
+    struct Proxy
+    {
+        AABB aabb;
+        CollisionFilterComponent filter;
+        std::shared_ptr<Entity> entity;
+    };
+
+    struct Endpoint
+    {
+        float value;
+        std::int32_t proxyId;
+        std::int32_t isMax; // at equal values min endpoints sort first, so touching boxes overlap as in AABB::intersects
+    };
+
+    std::vector<Proxy> proxies;
+    std::vector<int> freeProxies;
+
+    // sorting is deferred to the query, which is logically const
+    mutable std::vector<Endpoint> endpoints;
+    mutable std::size_t sortedEndpoints; // endpoints[0, sortedEndpoints) were sorted by the last query or build
+    mutable int sweepAxis;
+    mutable std::vector<std::int32_t> activeProxies;
+
+    static bool endpointLess(const Endpoint &a, const Endpoint &b);
+    int chooseSweepAxis() const;
+};
@@ -1,166 +1,448 @@
 #include "CollisionSystem.h"
 #include "NarrowPhase/SAT.h"
+#include "BroadPhase/AABBTree.h"
+#include "BroadPhase/SweepAndPrune.h"
+#include "BroadPhase/SpatialHashGrid.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/ColliderComponent.h"
-#include <iostream>
-#include <cfloat>
+#include <algorithm>
 
-#include "../Components/IDComponent.h"
-#include "../Components/ShapeType.h"
+#include "../Core/Tracer.h"
 #include "../Utilities/PolygonIntersection.h"
+#include "../Utilities/ColliderGeometry.h"
 
 #include "../Math/Vector2.h"
 
-std::string shapeTypeToString(ShapeType type)
+const size_t CollisionSystem::narrowPhaseChunkSize;
+
+static std::unique_ptr<BroadPhase> createBroadPhase(BroadPhaseType type)
 {
     switch (type)
     {
-    case ShapeType::Triangle:
-        return "Triangle";
-    case ShapeType::Square:
-        return "Square";
-    case ShapeType::Pentagon:
-        return "Pentagon";
-    case ShapeType::Hexagon:
-        return "Hexagon";
-    case ShapeType::Custom:
+    case BroadPhaseType::SweepAndPrune:
+        return std::unique_ptr<BroadPhase>(new SweepAndPrune());
+    case BroadPhaseType::SpatialHashGrid:
+        return std::unique_ptr<BroadPhase>(new SpatialHashGrid());
+    case BroadPhaseType::AABBTree:
     default:
-        return "Custom Shape";
+        return std::unique_ptr<BroadPhase>(new AABBTree());
     }
 }
 
-CollisionSystem::CollisionSystem(ECS &ecs) : ecs(ecs) {}
+CollisionSystem::CollisionSystem(ECS &ecs, BroadPhaseType broadPhaseType, NarrowPhaseType narrowPhaseType)
+    : ecs(ecs), broadPhase(createBroadPhase(broadPhaseType)), narrowPhaseType(narrowPhaseType), frame(0), separatingAxisCache(true),
+      pairCacheStats(), jobSystem(&JobSystem::shared()), intersectionPolygonsComplete(true)
+{
+    broadPhase->setJobSystem(jobSystem);
+}
+
+const AABBTree *CollisionSystem::getAABBTree() const
+{
+    return dynamic_cast<const AABBTree *>(broadPhase.get());
+}
+
+void CollisionSystem::setJobSystem(JobSystem &system)
+{
+    jobSystem = &system;
+    broadPhase->setJobSystem(jobSystem);
+}
+
+const CollisionSystem::PairCacheStats &CollisionSystem::getPairCacheStats() const
+{
+    return pairCacheStats;
+}
+
+void CollisionSystem::setSeparatingAxisCache(bool enabled)
+{
+    separatingAxisCache = enabled;
+}
 
-const std::map<std::pair<Entity *, Entity *>, std::vector<Vector2>> &CollisionSystem::getIntersectionPolygons() const
+void CollisionSystem::Counters::reset()
 {
+    treeBuildNanoseconds.reset();
+    pairQueryNanoseconds.reset();
+    narrowPhaseNanoseconds.reset();
+    mergeNanoseconds.reset();
+    clippingNanoseconds.reset();
+    candidatePairs.reset();
+    collisions.reset();
+}
+
+CollisionSystem::Stats CollisionSystem::getStats() const
+{
+    Stats stats;
+    stats.treeBuildMilliseconds = counters.treeBuildNanoseconds.get() / 1e6;
+    stats.pairQueryMilliseconds = counters.pairQueryNanoseconds.get() / 1e6;
+    stats.narrowPhaseMilliseconds = counters.narrowPhaseNanoseconds.get() / 1e6;
+    stats.mergeMilliseconds = counters.mergeNanoseconds.get() / 1e6;
+    stats.clippingMilliseconds = counters.clippingNanoseconds.get() / 1e6;
+    stats.candidatePairs = counters.candidatePairs.get();
+    stats.collisions = counters.collisions.get();
+    stats.falsePositiveRatio = stats.candidatePairs > 0 ? static_cast<double>(stats.candidatePairs - stats.collisions) / stats.candidatePairs : 0.0;
+    stats.treeDepth = broadPhase->getHeight();
+    stats.nodesVisited = broadPhase->getLastQueryNodesVisited();
+    return stats;
+}
+
+void CollisionSystem::setNarrowPhase(NarrowPhaseType type)
+{
+    narrowPhaseType = type;
+}
+
+static std::pair<Entity *, Entity *> orderedPair(Entity *entityA, Entity *entityB)
+{
+    return entityA < entityB ? std::make_pair(entityA, entityB) : std::make_pair(entityB, entityA);
+}
+
+// pair cache key, the smaller id in the high half
+static std::uint64_t pairKey(std::uint64_t idA, std::uint64_t idB)
+{
+    return idA < idB ? (idA << 32) | idB : (idB << 32) | idA;
+}
+
+static std::uint64_t pairKey(const Entity *entityA, const Entity *entityB)
+{
+    return pairKey(entityA->getId(), entityB->getId());
+}
+
+void CollisionSystem::flagIntersectionPolygon(Entity *entityA, Entity *entityB, bool flagged)
+{
+    if (flagged)
+        flaggedPairs.insert(pairKey(entityA, entityB));
+    else
+        flaggedPairs.erase(pairKey(entityA, entityB));
+}
+
+void CollisionSystem::setPairNarrowPhase(Entity *entityA, Entity *entityB, NarrowPhaseType type)
+{
+    pairNarrowPhases[orderedPair(entityA, entityB)] = type;
+}
+
+const std::vector<std::vector<Vector2>> &CollisionSystem::getIntersectionPolygons() const
+{
+    if (!intersectionPolygonsComplete)
+    {
+        for (size_t i = 0; i < collisionPairs.size(); ++i)
+        {
+            if (intersectionPolygonReady[i])
+                continue; // flagged, already done during update
+            computeIntersectionPolygon(collisionPairs[i].entityA, collisionPairs[i].entityB, intersectionPolygons[i]);
+        }
+        intersectionPolygonsComplete = true;
+    }
     return intersectionPolygons;
 }
 
+const CollisionSystem::CollisionEvents &CollisionSystem::getCollisionEvents() const
+{
+    return collisionEvents;
+}
+
+void CollisionSystem::computeIntersectionPolygon(Entity *entityA, Entity *entityB, std::vector<Vector2> &out) const
+{
+    INSTRUMENT_SCOPE(counters.clippingNanoseconds);
+
+    out.clear();
+    ColliderComponent *colliderA = entityA->getComponent<ColliderComponent>();
+    ColliderComponent *colliderB = entityB->getComponent<ColliderComponent>();
+    if (!colliderA || !colliderB)
+        return;
+
+    const std::vector<Vector2> &shapeA = colliderA->world.vertices;
+    const std::vector<Vector2> &shapeB = colliderB->world.vertices;
+    if (shapeA.size() + shapeB.size() <= PolygonIntersection::maxVertices)
+    {
+        Vector2 polygon[PolygonIntersection::maxVertices];
+        size_t count = PolygonIntersection::computeIntersection(shapeA.data(), shapeA.size(), shapeB.data(), shapeB.size(), polygon);
+        out.assign(polygon, polygon + count);
+    }
+    else
+    {
+        out = PolygonIntersection::computeIntersection(shapeA, shapeB);
+    }
+}
+
 void CollisionSystem::update()
 {
-    // take care of aretefacts
-    collisionPairs.clear(); // Clear previous collision data
-    intersectionPolygons.clear();
-    // Build the AABB tree with current entities
-    buildAABBTree();
+    // the last update's pairs become the reference for this update's events
+    previousPairs.swap(collisionPairs);
+    intersectionPolygonsComplete = false;
+    counters.reset();
+
+    // Bring the broad phase proxies up to date with the current entities
+    {
+        INSTRUMENT_SCOPE(counters.treeBuildNanoseconds);
+        buildAABBTree();
+    }
 
-    // Query the tree for potential collisions
+    // Query the broad phase for potential collisions
     std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> potentialCollisions;
-    tree.queryPotentialCollisions(potentialCollisions);
+    {
+        INSTRUMENT_SCOPE(counters.pairQueryNanoseconds);
+        TRACE_SCOPE("BroadPhase::queryPotentialCollisions");
+        broadPhase->queryPotentialCollisions(potentialCollisions);
+    }
+    INSTRUMENT_ADD(counters.candidatePairs, potentialCollisions.size());
 
     // Handle collisions
     handleCollisions(potentialCollisions);
 }
 
+JobSystem::JobHandle CollisionSystem::schedule(JobSystem &jobs)
+{
+    setJobSystem(jobs);
+    // the world geometry cache lives in the collider, so keeping it up to date counts as a write
+    return jobs.addJob("collision", componentMask<TransformComponent>(), componentMask<ColliderComponent>(), [this]() { update(); });
+}
+
 void CollisionSystem::buildAABBTree()
 {
-    tree = AABBTree(); // Reset the tree
+    TRACE_SCOPE("CollisionSystem::buildAABBTree");
+    auto colliders = ecs.view<TransformComponent, ColliderComponent>();
+
+    // When most of the scene is new (scene load, mass spawn) a bulk build beats inserting one by one
+    if (colliders.size() > 2 * proxies.size())
+    {
+        rebuildAABBTree();
+        return;
+    }
+
+    // Proxies persist between frames, only those whose tight box left their fat box get updated
+    colliders.each([this](Entity &entity, TransformComponent &transform, ColliderComponent &collider) {
+        const AABB &aabb = calculateAABB(transform, collider);
+
+        auto it = proxies.find(&entity);
+        if (it == proxies.end())
+        {
+            ProxyRecord record = {broadPhase->createProxy(entity.shared_from_this(), aabb), transform.position};
+            proxies[&entity] = record;
+        }
+        else
+        {
+            broadPhase->moveProxy(it->second.proxyId, aabb, transform.position - it->second.lastPosition);
+            it->second.lastPosition = transform.position;
+        }
+    });
+
+    // only entities with a filter are visited, and the broad phase only hears of filters that changed
+    ecs.view<ColliderComponent, CollisionFilterComponent>().each([this](Entity &entity, ColliderComponent &, CollisionFilterComponent &filter) {
+        auto it = proxies.find(&entity);
+        if (it != proxies.end() && broadPhase->getFilter(it->second.proxyId) != filter)
+            broadPhase->setFilter(it->second.proxyId, filter);
+    });
+}
+
+void CollisionSystem::rebuildAABBTree()
+{
+    std::vector<BroadPhaseEntry> entries;
+    std::vector<Vector2> positions;
+    ecs.view<TransformComponent, ColliderComponent>().each([&](Entity &entity, TransformComponent &transform, ColliderComponent &collider) {
+        CollisionFilterComponent *filter = entity.getComponent<CollisionFilterComponent>();
+        BroadPhaseEntry entry = {entity.shared_from_this(), calculateAABB(transform, collider), filter ? *filter : CollisionFilterComponent()};
+        entries.push_back(entry);
+        positions.push_back(transform.position);
+    });
 
-    for (const auto &entity : ecs.getEntities())
+    std::vector<int> proxyIds;
+    broadPhase->build(entries.data(), entries.size(), proxyIds);
+
+    proxies.clear();
+    for (size_t i = 0; i < entries.size(); ++i)
     {
-        AABB aabb = calculateAABB(entity.get());
-        tree.insert(entity, aabb);
+        ProxyRecord record = {proxyIds[i], positions[i]};
+        proxies[entries[i].entity.get()] = record;
     }
 }
-const std::set<std::pair<Entity *, Entity *>> &CollisionSystem::getCollisionPairs() const
+
+const std::vector<CollisionSystem::CollisionPair> &CollisionSystem::getCollisionPairs() const
 {
     return collisionPairs;
 }
 
-AABB CollisionSystem::calculateAABB(Entity *entity)
+const std::vector<ContactManifold> &CollisionSystem::getManifolds() const
+{
+    return manifolds;
+}
+
+const AABB &CollisionSystem::calculateAABB(const TransformComponent &transform, ColliderComponent &collider)
 {
-    auto transform = entity->getComponent<TransformComponent>();
-    auto collider = entity->getComponent<ColliderComponent>();
+    // only recomputed when the transform moved since the last call
+    ColliderGeometry::update(transform, collider);
+    return collider.world.aabb;
+}
 
-    if (!transform || !collider)
+bool CollisionSystem::testPair(Entity *entityA, const WorldGeometry &shapeA, Entity *entityB, const WorldGeometry &shapeB, PairCacheEntry &entry, NarrowPhaseChunk &chunk) const
+{
+    NarrowPhaseType type = narrowPhaseType;
+    if (!pairNarrowPhases.empty())
     {
-        return AABB();
+        auto it = pairNarrowPhases.find(orderedPair(entityA, entityB));
+        if (it != pairNarrowPhases.end())
+            type = it->second;
     }
+    if (type == NarrowPhaseType::Auto)
+        type = shapeA.vertices.size() + shapeB.vertices.size() >= gjkVertexThreshold ? NarrowPhaseType::GJK : NarrowPhaseType::SAT;
 
-    Vector2 min(FLT_MAX, FLT_MAX);
-    Vector2 max(-FLT_MAX, -FLT_MAX);
+    // the cached axis and simplex refer to the shapes in id order, which the caller passes them in
+    if (type == NarrowPhaseType::GJK)
+        return GJK::checkCollision(shapeA, shapeB, entry.simplex);
 
-    for (const auto &vert : collider->vertices)
+    ++chunk.satPairs;
+    if (!separatingAxisCache)
     {
-        // Apply transformations
-        Vector2 worldVert = transform->position + collider->offset + (vert * transform->scale);
-
-        min.x = std::min(min.x, worldVert.x);
-        min.y = std::min(min.y, worldVert.y);
-        max.x = std::max(max.x, worldVert.x);
-        max.y = std::max(max.y, worldVert.y);
+        SeparatingAxis none;
+        return SAT::checkCollision(shapeA, shapeB, none, chunk.satAxesTested);
     }
 
-    return AABB(min, max);
+    bool hadAxis = entry.axis.shape < 2;
+    size_t axesBefore = chunk.satAxesTested;
+    bool colliding = SAT::checkCollision(shapeA, shapeB, entry.axis, chunk.satAxesTested);
+    if (hadAxis && chunk.satAxesTested - axesBefore == 1 && !colliding)
+        ++chunk.cachedAxisHits;
+    return colliding;
 }
-void CollisionSystem::handleCollisions(const std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions)
+
+void CollisionSystem::processNarrowPhaseChunk(const std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>> *pairs, PairCacheEntry *const *entries, size_t count,
+                                              NarrowPhaseChunk &chunk) const
 {
-    for (const auto &pair : collisions)
+    chunk.contacts.clear();
+    chunk.satPairs = 0;
+    chunk.satAxesTested = 0;
+    chunk.cachedAxisHits = 0;
+
+    for (size_t i = 0; i < count; ++i)
     {
-        Entity *entityA = pair.first.get();
-        Entity *entityB = pair.second.get();
+        // pairs are stored and tested with the smaller id first
+        Entity *entityA = pairs[i].first.get();
+        Entity *entityB = pairs[i].second.get();
+        if (entityB->getId() < entityA->getId())
+            std::swap(entityA, entityB);
 
         auto transformA = entityA->getComponent<TransformComponent>();
         auto colliderA = entityA->getComponent<ColliderComponent>();
-        auto idA = entityA->getComponent<IDComponent>();
 
         auto transformB = entityB->getComponent<TransformComponent>();
         auto colliderB = entityB->getComponent<ColliderComponent>();
-        auto idB = entityB->getComponent<IDComponent>();
 
         if (!transformA || !colliderA || !transformB || !colliderB)
             continue;
 
-        // Generate world space vertices
-        std::vector<Vector2> shapeA_world, shapeB_world;
-
-        // Apply rotation to shape A
-        float rotationA_rad = transformA->rotation * (M_PI / 180.0f);
-        for (const auto &vert : colliderA->vertices)
+        // World space vertices and normals were brought up to date by buildAABBTree
+        // Narrow Phase collision detection
+        if (testPair(entityA, colliderA->world, entityB, colliderB->world, *entries[i], chunk))
         {
-            Vector2 localVert = vert * transformA->scale;
-            float rotatedX = localVert.x * std::cos(rotationA_rad) - localVert.y * std::sin(rotationA_rad);
-            float rotatedY = localVert.x * std::sin(rotationA_rad) + localVert.y * std::cos(rotationA_rad);
-            Vector2 worldVert = transformA->position + colliderA->offset + Vector2(rotatedX, rotatedY);
-            shapeA_world.push_back(worldVert);
+            Contact contact;
+            contact.pair.idA = entityA->getId();
+            contact.pair.idB = entityB->getId();
+            contact.pair.entityA = entityA;
+            contact.pair.entityB = entityB;
+            Manifold::collide(colliderA->world, colliderB->world, contact.manifold);
+            chunk.contacts.push_back(contact);
         }
+    }
+}
 
-        // Apply rotation to shape B
-        float rotationB_rad = transformB->rotation * (M_PI / 180.0f);
-        for (const auto &vert : colliderB->vertices)
+void CollisionSystem::handleCollisions(const std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions)
+{
+    TRACE_SCOPE("CollisionSystem::handleCollisions");
+    size_t chunkCount = (collisions.size() + narrowPhaseChunkSize - 1) / narrowPhaseChunkSize;
+    {
+        INSTRUMENT_SCOPE(counters.narrowPhaseNanoseconds);
+
+        // find or create every candidate's cache entry up front, chunks then only touch their own pairs' entries
+        ++frame;
+        pairCacheStats = PairCacheStats();
+        pairCacheStats.candidatePairs = collisions.size();
+        candidateEntries.resize(collisions.size());
+        for (size_t i = 0; i < collisions.size(); ++i)
         {
-            Vector2 localVert = vert * transformB->scale;
-            float rotatedX = localVert.x * std::cos(rotationB_rad) - localVert.y * std::sin(rotationB_rad);
-            float rotatedY = localVert.x * std::sin(rotationB_rad) + localVert.y * std::cos(rotationB_rad);
-            Vector2 worldVert = transformB->position + colliderB->offset + Vector2(rotatedX, rotatedY);
-            shapeB_world.push_back(worldVert);
+            auto result = pairCache.emplace(pairKey(collisions[i].first.get(), collisions[i].second.get()), PairCacheEntry());
+            if (!result.second)
+                ++pairCacheStats.cacheHits;
+            result.first->second.frame = frame;
+            candidateEntries[i] = &result.first->second;
         }
 
-        // Narrow Phase collision detection
-        if (SAT::checkCollision(shapeA_world, shapeB_world))
-        {
-            // Store the pair for visualization
-            collisionPairs.insert({entityA, entityB});
+        // chunks only read shared state and write their own buffers and cache entries
+        if (narrowPhaseChunks.size() < chunkCount)
+            narrowPhaseChunks.resize(chunkCount);
 
-            // Compute the intersection polygon
-            std::vector<Vector2> intersectionPolygon = PolygonIntersection::computeIntersection(shapeA_world, shapeB_world);
-            if (!intersectionPolygon.empty())
-            {
-                intersectionPolygons[{entityA, entityB}] = intersectionPolygon;
-            }
+        jobSystem->parallelFor(chunkCount, [&](size_t i) {
+            size_t begin = i * narrowPhaseChunkSize;
+            size_t count = std::min(narrowPhaseChunkSize, collisions.size() - begin);
+            processNarrowPhaseChunk(collisions.data() + begin, candidateEntries.data() + begin, count, narrowPhaseChunks[i]);
+        });
+    }
 
-            // Output detailed collision information
-            std::string idA_str = idA ? idA->id : "Unknown";
-            std::string idB_str = idB ? idB->id : "Unknown";
+    INSTRUMENT_SCOPE(counters.mergeNanoseconds);
+    contacts.clear();
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const NarrowPhaseChunk &chunk = narrowPhaseChunks[i];
+        INSTRUMENT_ADD(counters.collisions, chunk.contacts.size());
+        contacts.insert(contacts.end(), chunk.contacts.begin(), chunk.contacts.end());
+        pairCacheStats.satPairs += chunk.satPairs;
+        pairCacheStats.satAxesTested += chunk.satAxesTested;
+        pairCacheStats.cachedAxisHits += chunk.cachedAxisHits;
+    }
+
+    // the broad phase reports every pair once, so sorting by ids alone gives the same order on every thread count
+    std::sort(contacts.begin(), contacts.end(), [](const Contact &a, const Contact &b) { return a.pair < b.pair; });
+    collisionPairs.resize(contacts.size());
+    manifolds.resize(contacts.size());
+    intersectionPolygons.resize(contacts.size());
+    intersectionPolygonReady.assign(contacts.size(), 0);
+    for (size_t i = 0; i < contacts.size(); ++i)
+    {
+        collisionPairs[i] = contacts[i].pair;
+        manifolds[i] = contacts[i].manifold;
+
+        // Intersection polygons are left to getIntersectionPolygons unless the pair asked for one
+        if (!flaggedPairs.empty() && flaggedPairs.count(pairKey(contacts[i].pair.idA, contacts[i].pair.idB)))
+        {
+            computeIntersectionPolygon(contacts[i].pair.entityA, contacts[i].pair.entityB, intersectionPolygons[i]);
+            intersectionPolygonReady[i] = 1;
+        }
+    }
+    updateCollisionEvents();
 
-            std::string shapeA_str = shapeTypeToString(colliderA->shapeType);
-            std::string shapeB_str = shapeTypeToString(colliderB->shapeType);
+    // pairs the broad phase did not report this update have separated fat AABBs
+    for (auto it = pairCache.begin(); it != pairCache.end();)
+    {
+        if (it->second.frame != frame)
+        {
+            it = pairCache.erase(it);
+            ++pairCacheStats.evictedPairs;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
 
-            Vector2 posA = transformA->position;
-            Vector2 posB = transformB->position;
+void CollisionSystem::updateCollisionEvents()
+{
+    collisionEvents.onCollisionBegin.clear();
+    collisionEvents.onCollisionStay.clear();
+    collisionEvents.onCollisionEnd.clear();
 
-            // std::cout << "Collision detected between Entity " << idA_str << " (" << shapeA_str << ") at position (" << posA.x << ", " << posA.y << ")"
-            //           << " and Entity " << idB_str << " (" << shapeB_str << ") at position (" << posB.x << ", " << posB.y << ")\n";
+    // both lists are sorted, so one merge-like walk splits them into the three events
+    size_t previous = 0, current = 0;
+    while (previous < previousPairs.size() || current < collisionPairs.size())
+    {
+        if (current == collisionPairs.size() || (previous < previousPairs.size() && previousPairs[previous] < collisionPairs[current]))
+        {
+            collisionEvents.onCollisionEnd.push_back(previousPairs[previous++]);
+        }
+        else if (previous == previousPairs.size() || collisionPairs[current] < previousPairs[previous])
+        {
+            collisionEvents.onCollisionBegin.push_back(collisionPairs[current++]);
+        }
+        else
+        {
+            collisionEvents.onCollisionStay.push_back(collisionPairs[current++]);
+            ++previous;
         }
     }
-}
\ No newline at end of file
+}
@@ -1,30 +1,200 @@
 #pragma once
 
 #include "../Core/ECS.h"
+#include "../Core/JobSystem.h"
+#include "../Core/Instrumentation.h"
+#include "BroadPhase/BroadPhase.h"
 #include "BroadPhase/AABBTree.h"
-#include <set>
+#include "NarrowPhase/NarrowPhase.h"
+#include "NarrowPhase/SAT.h"
+#include "NarrowPhase/GJK.h"
+#include "NarrowPhase/Manifold.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/ColliderComponent.h"
+#include "../Components/CollisionFilterComponent.h"
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 class CollisionSystem
 {
 public:
-    CollisionSystem(ECS &ecs);
+    CollisionSystem(ECS &ecs, BroadPhaseType broadPhaseType = BroadPhaseType::AABBTree, NarrowPhaseType narrowPhaseType = NarrowPhaseType::Auto);
     void update();
 
-    // Getter for collision pairs
-    const std::set<std::pair<Entity *, Entity *>> &getCollisionPairs() const;
+    // Adds update as a job of the next jobSystem.run(), ordered after the jobs writing the components it reads.
+    // The query and narrow phase run on jobSystem too, which stays the system's job system afterwards.
+    JobSystem::JobHandle schedule(JobSystem &jobSystem);
 
-    // Getter for intersection polygons, this si for visualization purposes
-    const std::map<std::pair<Entity *, Entity *>, std::vector<Vector2>> &getIntersectionPolygons() const;
+    // narrow phase used for every pair without a setting of its own
+    void setNarrowPhase(NarrowPhaseType type);
+
+    // overrides the narrow phase for one pair, the order of the two entities does not matter
+    void setPairNarrowPhase(Entity *entityA, Entity *entityB, NarrowPhaseType type);
+
+    // job system the broad phase query and the narrow phase chunks run on, JobSystem::shared() unless set
+    void setJobSystem(JobSystem &jobSystem);
+
+    // what the pair cache did during the last update
+    struct PairCacheStats
+    {
+        size_t candidatePairs;  // pairs reported by the broad phase
+        size_t cacheHits;       // of those, pairs already cached by the update before
+        size_t evictedPairs;    // cached pairs whose fat AABBs stopped overlapping
+        size_t satPairs;        // pairs tested with SAT
+        size_t satAxesTested;   // axes those tests projected onto
+        size_t cachedAxisHits;  // SAT pairs separated by their remembered axis alone
+    };
+    const PairCacheStats &getPairCacheStats() const;
+
+    // SAT tries each pair's last separating axis first unless disabled, which is only useful for comparison
+    void setSeparatingAxisCache(bool enabled);
+
+    // Snapshot of the last update's instrumentation, times in milliseconds. Clipping covers the intersection
+    // polygons computed so far, during the update for flagged pairs and in getIntersectionPolygons for the rest.
+    // The timed and counted fields stay 0 when built with COLLISION_INSTRUMENTATION=0.
+    struct Stats
+    {
+        double treeBuildMilliseconds; // broad phase proxies brought up to date with the colliders
+        double pairQueryMilliseconds;
+        double narrowPhaseMilliseconds;
+        double mergeMilliseconds; // chunk results sorted into the pair vectors, events diffed, stale cache entries evicted
+        double clippingMilliseconds;
+        size_t candidatePairs;
+        size_t collisions;
+        double falsePositiveRatio; // share of candidate pairs the narrow phase rejected
+        int treeDepth;             // 0 for broad phases without a tree
+        size_t nodesVisited;       // by the last pair query, 0 if the broad phase does not count them
+    };
+    Stats getStats() const;
+
+    // a colliding pair, the entity with the smaller id first
+    struct CollisionPair
+    {
+        EntityId idA;
+        EntityId idB;
+        Entity *entityA;
+        Entity *entityB;
+
+        bool operator<(const CollisionPair &other) const { return idA != other.idA ? idA < other.idA : idB < other.idB; }
+        bool operator==(const CollisionPair &other) const { return idA == other.idA && idB == other.idB; }
+        bool operator!=(const CollisionPair &other) const { return !(*this == other); }
+    };
+
+    // Colliding pairs of the last update, sorted by idA then idB. The vectors below are indexed the same way.
+    const std::vector<CollisionPair> &getCollisionPairs() const;
+
+    // Contact normal (from entityA to entityB), depth and points of every colliding pair. A pair SAT or GJK found
+    // colliding but only touching has no contact points.
+    const std::vector<ContactManifold> &getManifolds() const;
+
+    // Getter for intersection polygons, this si for visualization purposes. They are only computed here, on the
+    // first call after an update, from the geometry at the time of the call; empty where the overlap has no area.
+    const std::vector<std::vector<Vector2>> &getIntersectionPolygons() const;
+
+    // the last update's pairs compared with the update before, each list sorted like getCollisionPairs
+    struct CollisionEvents
+    {
+        std::vector<CollisionPair> onCollisionBegin; // colliding now, not before
+        std::vector<CollisionPair> onCollisionStay;  // colliding in both
+        std::vector<CollisionPair> onCollisionEnd;   // colliding before, not now
+    };
+    const CollisionEvents &getCollisionEvents() const;
+
+    // The broad phase tree for spatial queries (AABBTree::queryAABB, queryPoint, rayCast, nearest), nullptr with
+    // another broad phase. It holds the entities as of the last update.
+    const AABBTree *getAABBTree() const;
+
+    // a flagged pair gets its intersection polygon computed during update whenever it collides
+    void flagIntersectionPolygon(Entity *entityA, Entity *entityB, bool flagged = true);
 
 private:
     ECS &ecs;
-    AABBTree tree;
+    std::unique_ptr<BroadPhase> broadPhase;
+
+    // each entity keeps its broad phase proxy across frames
+    struct ProxyRecord
+    {
+        int proxyId;
+        Vector2 lastPosition; // used to predict the displacement for the fat AABB
+    };
+    std::unordered_map<Entity *, ProxyRecord> proxies;
+
+    // Auto switches to GJK once a pair has at least this many vertices in total
+    static const size_t gjkVertexThreshold = 16;
+
+    NarrowPhaseType narrowPhaseType;
+    std::map<std::pair<Entity *, Entity *>, NarrowPhaseType> pairNarrowPhases;
+
+    // Narrow phase state carried from one update to the next for every candidate pair, keyed by the two entity ids,
+    // smaller first, and the shape indices inside refer to the entities in that order. A pair is evicted as soon as
+    // the broad phase stops reporting it, that is once its fat AABBs no longer overlap.
+    struct PairCacheEntry
+    {
+        SeparatingAxis axis;   // SAT: the axis that separated the pair last time it was tested
+        SimplexCache simplex;  // GJK: the last simplex
+        std::uint32_t frame;   // last update the pair was a candidate in
+    };
+    std::unordered_map<std::uint64_t, PairCacheEntry> pairCache;
+    std::vector<PairCacheEntry *> candidateEntries; // entry of every candidate pair of the current update
+    std::uint32_t frame;
+    bool separatingAxisCache;
+    PairCacheStats pairCacheStats;
+
+    // instrumentation of the current update, mutable since clipping also happens in getIntersectionPolygons
+    struct Counters
+    {
+        StatCounter treeBuildNanoseconds;
+        StatCounter pairQueryNanoseconds;
+        StatCounter narrowPhaseNanoseconds;
+        StatCounter mergeNanoseconds;
+        StatCounter clippingNanoseconds;
+        StatCounter candidatePairs;
+        StatCounter collisions;
+
+        void reset();
+    };
+    mutable Counters counters;
+
+    // What one chunk of candidate pairs produced. Chunks are merged in order after all of them finished, so the
+    // results do not depend on the thread count or timing.
+    struct Contact
+    {
+        CollisionPair pair;
+        ContactManifold manifold;
+    };
+    struct NarrowPhaseChunk
+    {
+        std::vector<Contact> contacts;
+        size_t satPairs;
+        size_t satAxesTested;
+        size_t cachedAxisHits;
+    };
+
+    // candidate pairs per chunk, small enough to balance the load, large enough to amortise claiming it
+    static const size_t narrowPhaseChunkSize = 256;
+
+    JobSystem *jobSystem;
+    std::vector<NarrowPhaseChunk> narrowPhaseChunks; // kept to reuse their buffers
 
-    std::set<std::pair<Entity *, Entity *>> collisionPairs;
-    std::map<std::pair<Entity *, Entity *>, std::vector<Vector2>> intersectionPolygons;
+    // Flat and sorted by entity ids, rebuilt in place every update so they only allocate while growing
+    std::vector<Contact> contacts; // merge buffer
+    std::vector<CollisionPair> collisionPairs;
+    std::vector<CollisionPair> previousPairs;
+    std::vector<ContactManifold> manifolds;
+    mutable std::vector<std::vector<Vector2>> intersectionPolygons;
+    mutable std::vector<unsigned char> intersectionPolygonReady;
+    mutable bool intersectionPolygonsComplete;
+    CollisionEvents collisionEvents;
+    std::unordered_set<std::uint64_t> flaggedPairs; // pair cache keys
 
     void buildAABBTree();
-    AABB calculateAABB(Entity *entity);
+    void rebuildAABBTree();
+    const AABB &calculateAABB(const TransformComponent &transform, ColliderComponent &collider);
+    void computeIntersectionPolygon(Entity *entityA, Entity *entityB, std::vector<Vector2> &out) const;
+    bool testPair(Entity *entityA, const WorldGeometry &shapeA, Entity *entityB, const WorldGeometry &shapeB, PairCacheEntry &entry, NarrowPhaseChunk &chunk) const;
+    void processNarrowPhaseChunk(const std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>> *pairs, PairCacheEntry *const *entries, size_t count,
+                                 NarrowPhaseChunk &chunk) const;
     void handleCollisions(const std::vector<std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>>> &collisions);
+    void updateCollisionEvents();
 };
@@ -2,77 +2,68 @@
 #include "../Components/TransformComponent.h"
 #include "../Components/VelocityComponent.h"
 #include "../Components/ColliderComponent.h"
+#include "../Utilities/ColliderGeometry.h"
+#include "../Core/Tracer.h"
 #include <cfloat>
-#include <SFML/Graphics.hpp>
 
-MovementSystem::MovementSystem(ECS &ecs) : ecs(ecs) {}
+MovementSystem::MovementSystem(ECS &ecs) : ecs(ecs), jobSystem(&JobSystem::shared()) {}
 
-void MovementSystem::update(float deltaTime, const sf::Vector2u &windowSize)
+JobSystem::JobHandle MovementSystem::schedule(JobSystem &jobs, float deltaTime, const Vector2 &bounds)
 {
-    for (const auto &entity : ecs.getEntities())
-    {
-        auto transform = entity->getComponent<TransformComponent>();
-        auto velocity = entity->getComponent<VelocityComponent>();
-        auto collider = entity->getComponent<ColliderComponent>();
+    setJobSystem(jobs);
+    ComponentMask writes = componentMask<TransformComponent, VelocityComponent, ColliderComponent>();
+    return jobs.addJob("movement", 0, writes, [this, deltaTime, bounds]() { update(deltaTime, bounds); });
+}
 
-        if (transform && velocity && collider)
-        {
-            // Update position
-            transform->position = transform->position + (velocity->velocity * deltaTime);
-
-            // Get entity bounds
-            Vector2 min(FLT_MAX, FLT_MAX);
-            Vector2 max(-FLT_MAX, -FLT_MAX);
-
-            // Convert rotation to radians
-            float rotationRad = transform->rotation * (M_PI / 180.0f);
-
-            for (const auto &vert : collider->vertices)
-            {
-                Vector2 localVert = vert * transform->scale;
+void MovementSystem::setJobSystem(JobSystem &system)
+{
+    jobSystem = &system;
+}
 
-                // Apply rotation
-                float rotatedX = localVert.x * std::cos(rotationRad) - localVert.y * std::sin(rotationRad);
-                float rotatedY = localVert.x * std::sin(rotationRad) + localVert.y * std::cos(rotationRad);
+void MovementSystem::update(float deltaTime, const Vector2 &bounds)
+{
+    TRACE_SCOPE("MovementSystem::update");
 
-                Vector2 worldVert = transform->position + collider->offset + Vector2(rotatedX, rotatedY);
+    // Check bounds, the window size in the example
+    float windowWidth = bounds.x;
+    float windowHeight = bounds.y;
 
-                min.x = std::min(min.x, worldVert.x);
-                min.y = std::min(min.y, worldVert.y);
-                max.x = std::max(max.x, worldVert.x);
-                max.y = std::max(max.y, worldVert.y);
-            }
+    // every entity only touches its own components, so chunks can run on several threads
+    ecs.view<TransformComponent, VelocityComponent, ColliderComponent>().parallelEach(
+        *jobSystem, [=](Entity &, TransformComponent &transform, VelocityComponent &velocity, ColliderComponent &collider) {
+            // Update position
+            transform.position = transform.position + (velocity.velocity * deltaTime);
 
-            // Check window bounds using dynamic window size
-            float windowWidth = static_cast<float>(windowSize.x);
-            float windowHeight = static_cast<float>(windowSize.y);
+            // Get entity bounds from the cached world geometry, it is only rebuilt because the position changed
+            ColliderGeometry::update(transform, collider);
+            Vector2 min = collider.world.aabb.min;
+            Vector2 max = collider.world.aabb.max;
 
             if (min.x < 0.0f || max.x > windowWidth)
             {
-                velocity->velocity.x *= -1.0f;
+                velocity.velocity.x *= -1.0f;
                 // Correct position if out of bounds
                 if (min.x < 0.0f)
                 {
-                    transform->position.x += -min.x;
+                    transform.position.x += -min.x;
                 }
                 else if (max.x > windowWidth)
                 {
-                    transform->position.x -= (max.x - windowWidth);
+                    transform.position.x -= (max.x - windowWidth);
                 }
             }
             if (min.y < 0.0f || max.y > windowHeight)
             {
-                velocity->velocity.y *= -1.0f;
+                velocity.velocity.y *= -1.0f;
                 // Correct position if out of bounds
                 if (min.y < 0.0f)
                 {
-                    transform->position.y += -min.y;
+                    transform.position.y += -min.y;
                 }
                 else if (max.y > windowHeight)
                 {
-                    transform->position.y -= (max.y - windowHeight);
+                    transform.position.y -= (max.y - windowHeight);
                 }
             }
-        }
-    }
-}
\ No newline at end of file
+        });
+}
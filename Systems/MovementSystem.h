@@ -1,14 +1,24 @@
 #pragma once
 
 #include "../Core/ECS.h"
-#include <SFML/Graphics.hpp>
+#include "../Core/JobSystem.h"
+#include "../Math/Vector2.h"
 
 class MovementSystem
 {
 public:
     MovementSystem(ECS &ecs);
-    void update(float deltaTime, const sf::Vector2u &windowSize);
+    // moves every entity by its velocity and bounces it off the edges of the area from (0, 0) to bounds
+    void update(float deltaTime, const Vector2 &bounds);
+
+    // Adds update as a job of the next jobSystem.run(), ordered after the jobs touching the components it writes.
+    // Its chunks run on jobSystem too, which stays the system's job system afterwards.
+    JobSystem::JobHandle schedule(JobSystem &jobSystem, float deltaTime, const Vector2 &bounds);
+
+    // job system the chunks of update run on, JobSystem::shared() unless set
+    void setJobSystem(JobSystem &jobSystem);
 
 private:
     ECS &ecs;
+    JobSystem *jobSystem;
 };
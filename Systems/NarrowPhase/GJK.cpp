@@ -0,0 +1,339 @@
+#include "GJK.h"
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+// Follows the b2Distance structure of Box2D: the simplex lives in the Minkowski difference B - A and is reduced to
+// the sub-simplex closest to the origin after every new support point.
+
+const float GJK::tolerance = 1e-4f;
+const size_t GJK::maxVertices;
+
+static const int maxIterations = 20;
+
+static float cross(const Vector2 &a, const Vector2 &b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+static int support(const WorldGeometry &shape, const Vector2 &direction)
+{
+    int best = 0;
+    float bestValue = shape.vertices[0].dot(direction);
+    for (size_t i = 1; i < shape.vertices.size(); ++i)
+    {
+        float value = shape.vertices[i].dot(direction);
+        if (value > bestValue)
+        {
+            best = static_cast<int>(i);
+            bestValue = value;
+        }
+    }
+    return best;
+}
+
+struct SimplexVertex
+{
+    Vector2 wA; // support point on A
+    Vector2 wB; // support point on B
+    Vector2 w;  // wB - wA
+    float a;    // barycentric weight of the closest point
+    int indexA;
+    int indexB;
+};
+
+struct Simplex
+{
+    SimplexVertex v[3];
+    int count;
+
+    void setVertex(SimplexVertex &vertex, const WorldGeometry &shapeA, const WorldGeometry &shapeB, int indexA, int indexB)
+    {
+        vertex.indexA = indexA;
+        vertex.indexB = indexB;
+        vertex.wA = shapeA.vertices[indexA];
+        vertex.wB = shapeB.vertices[indexB];
+        vertex.w = vertex.wB - vertex.wA;
+        vertex.a = 0.0f;
+    }
+
+    void readCache(const SimplexCache &cache, const WorldGeometry &shapeA, const WorldGeometry &shapeB)
+    {
+        count = cache.count;
+        for (int i = 0; i < count; ++i)
+        {
+            // the cache may come from a different shape
+            if (cache.indexA[i] >= shapeA.vertices.size() || cache.indexB[i] >= shapeB.vertices.size())
+            {
+                count = 0;
+                break;
+            }
+            setVertex(v[i], shapeA, shapeB, cache.indexA[i], cache.indexB[i]);
+        }
+
+        // a simplex that shrank, grew or collapsed since it was cached would mislead the first iterations
+        if (count > 1)
+        {
+            float cachedMetric = cache.metric;
+            float currentMetric = metric();
+            if (currentMetric < 0.5f * cachedMetric || 2.0f * cachedMetric < currentMetric || currentMetric < FLT_EPSILON)
+                count = 0;
+        }
+
+        if (count == 0)
+        {
+            setVertex(v[0], shapeA, shapeB, 0, 0);
+            v[0].a = 1.0f;
+            count = 1;
+        }
+    }
+
+    void writeCache(SimplexCache &cache) const
+    {
+        cache.metric = metric();
+        cache.count = static_cast<uint16_t>(count);
+        for (int i = 0; i < count; ++i)
+        {
+            cache.indexA[i] = static_cast<uint16_t>(v[i].indexA);
+            cache.indexB[i] = static_cast<uint16_t>(v[i].indexB);
+        }
+    }
+
+    // length of a segment, area (times two) of a triangle
+    float metric() const
+    {
+        switch (count)
+        {
+        case 2:
+            return (v[1].w - v[0].w).length();
+        case 3:
+            return std::abs(cross(v[1].w - v[0].w, v[2].w - v[0].w));
+        default:
+            return 0.0f;
+        }
+    }
+
+    Vector2 searchDirection() const
+    {
+        if (count == 1)
+            return v[0].w * -1.0f;
+
+        // towards the origin from the segment
+        Vector2 e12 = v[1].w - v[0].w;
+        if (cross(e12, v[0].w * -1.0f) > 0.0f)
+            return Vector2(-e12.y, e12.x);
+        return Vector2(e12.y, -e12.x);
+    }
+
+    void witnessPoints(Vector2 &pointA, Vector2 &pointB) const
+    {
+        switch (count)
+        {
+        case 1:
+            pointA = v[0].wA;
+            pointB = v[0].wB;
+            break;
+        case 2:
+            pointA = v[0].wA * v[0].a + v[1].wA * v[1].a;
+            pointB = v[0].wB * v[0].a + v[1].wB * v[1].a;
+            break;
+        default:
+            pointA = v[0].wA * v[0].a + v[1].wA * v[1].a + v[2].wA * v[2].a;
+            pointB = pointA;
+            break;
+        }
+    }
+
+    // closest point of a segment to the origin, in barycentric coordinates
+    void solve2()
+    {
+        Vector2 e12 = v[1].w - v[0].w;
+
+        float d12_2 = -v[0].w.dot(e12);
+        if (d12_2 <= 0.0f)
+        {
+            v[0].a = 1.0f;
+            count = 1;
+            return;
+        }
+
+        float d12_1 = v[1].w.dot(e12);
+        if (d12_1 <= 0.0f)
+        {
+            v[1].a = 1.0f;
+            v[0] = v[1];
+            count = 1;
+            return;
+        }
+
+        float inv = 1.0f / (d12_1 + d12_2);
+        v[0].a = d12_1 * inv;
+        v[1].a = d12_2 * inv;
+        count = 2;
+    }
+
+    // closest feature of a triangle to the origin, checking vertex, edge and interior regions
+    void solve3()
+    {
+        Vector2 w1 = v[0].w;
+        Vector2 w2 = v[1].w;
+        Vector2 w3 = v[2].w;
+
+        Vector2 e12 = w2 - w1;
+        float d12_1 = w2.dot(e12);
+        float d12_2 = -w1.dot(e12);
+
+        Vector2 e13 = w3 - w1;
+        float d13_1 = w3.dot(e13);
+        float d13_2 = -w1.dot(e13);
+
+        Vector2 e23 = w3 - w2;
+        float d23_1 = w3.dot(e23);
+        float d23_2 = -w2.dot(e23);
+
+        float n123 = cross(e12, e13);
+        float d123_1 = n123 * cross(w2, w3);
+        float d123_2 = n123 * cross(w3, w1);
+        float d123_3 = n123 * cross(w1, w2);
+
+        if (d12_2 <= 0.0f && d13_2 <= 0.0f)
+        {
+            v[0].a = 1.0f;
+            count = 1;
+            return;
+        }
+
+        if (d12_1 > 0.0f && d12_2 > 0.0f && d123_3 <= 0.0f)
+        {
+            float inv = 1.0f / (d12_1 + d12_2);
+            v[0].a = d12_1 * inv;
+            v[1].a = d12_2 * inv;
+            count = 2;
+            return;
+        }
+
+        if (d13_1 > 0.0f && d13_2 > 0.0f && d123_2 <= 0.0f)
+        {
+            float inv = 1.0f / (d13_1 + d13_2);
+            v[0].a = d13_1 * inv;
+            v[2].a = d13_2 * inv;
+            v[1] = v[2];
+            count = 2;
+            return;
+        }
+
+        if (d12_1 <= 0.0f && d23_2 <= 0.0f)
+        {
+            v[1].a = 1.0f;
+            v[0] = v[1];
+            count = 1;
+            return;
+        }
+
+        if (d13_1 <= 0.0f && d23_1 <= 0.0f)
+        {
+            v[2].a = 1.0f;
+            v[0] = v[2];
+            count = 1;
+            return;
+        }
+
+        if (d23_1 > 0.0f && d23_2 > 0.0f && d123_1 <= 0.0f)
+        {
+            float inv = 1.0f / (d23_1 + d23_2);
+            v[1].a = d23_1 * inv;
+            v[2].a = d23_2 * inv;
+            v[0] = v[2];
+            count = 2;
+            return;
+        }
+
+        // the origin is inside the triangle
+        float inv = 1.0f / (d123_1 + d123_2 + d123_3);
+        v[0].a = d123_1 * inv;
+        v[1].a = d123_2 * inv;
+        v[2].a = d123_3 * inv;
+        count = 3;
+    }
+};
+
+DistanceOutput GJK::distance(const WorldGeometry &shapeA, const WorldGeometry &shapeB, SimplexCache &cache)
+{
+    DistanceOutput output;
+    output.iterations = 0;
+    if (shapeA.vertices.empty() || shapeB.vertices.empty())
+    {
+        output.distance = FLT_MAX;
+        return output;
+    }
+
+    assert(shapeA.vertices.size() <= maxVertices && shapeB.vertices.size() <= maxVertices && "too many vertices for SimplexCache");
+
+    Simplex simplex;
+    simplex.readCache(cache, shapeA, shapeB);
+
+    // a cached simplex has stale weights, reducing it first recomputes them
+    int saveA[3], saveB[3];
+    while (output.iterations < maxIterations)
+    {
+        int saveCount = simplex.count;
+        for (int i = 0; i < saveCount; ++i)
+        {
+            saveA[i] = simplex.v[i].indexA;
+            saveB[i] = simplex.v[i].indexB;
+        }
+
+        if (simplex.count == 2)
+            simplex.solve2();
+        else if (simplex.count == 3)
+            simplex.solve3();
+
+        // the origin is inside the triangle, the shapes overlap
+        if (simplex.count == 3)
+            break;
+
+        Vector2 direction = simplex.searchDirection();
+
+        // the origin lies on the simplex, so the shapes touch or overlap
+        if (direction.dot(direction) < FLT_EPSILON * FLT_EPSILON)
+            break;
+
+        SimplexVertex &vertex = simplex.v[simplex.count];
+        simplex.setVertex(vertex, shapeA, shapeB, support(shapeA, direction * -1.0f), support(shapeB, direction));
+        ++output.iterations;
+
+        // a support point seen before means no further progress, the simplex is as close as it gets
+        bool duplicate = false;
+        for (int i = 0; i < saveCount; ++i)
+        {
+            if (vertex.indexA == saveA[i] && vertex.indexB == saveB[i])
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate)
+            break;
+
+        ++simplex.count;
+    }
+
+    // ran out of iterations with an unreduced simplex
+    if (output.iterations == maxIterations)
+    {
+        if (simplex.count == 2)
+            simplex.solve2();
+        else if (simplex.count == 3)
+            simplex.solve3();
+    }
+
+    simplex.witnessPoints(output.pointA, output.pointB);
+    output.distance = simplex.count == 3 ? 0.0f : (output.pointB - output.pointA).length();
+    simplex.writeCache(cache);
+    return output;
+}
+
+bool GJK::checkCollision(const WorldGeometry &shapeA, const WorldGeometry &shapeB, SimplexCache &cache)
+{
+    return distance(shapeA, shapeB, cache).distance <= tolerance;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include "../../Math/Vector2.h"
+#include "../../Components/WorldGeometry.h"
+
+// Vertex indices of the simplex GJK finished with, fed back in the next frame so a pair that barely moved converges
+// in one or two iterations. A default constructed cache is cold.
+struct SimplexCache
+{
+    float metric; // length or area of the simplex, a cached one whose size changed a lot is dropped
+    uint16_t count;
+    uint16_t indexA[3];
+    uint16_t indexB[3];
+
+    SimplexCache() : metric(0.0f), count(0) {}
+};
+
+struct DistanceOutput
+{
+    Vector2 pointA; // closest point on shape A
+    Vector2 pointB; // closest point on shape B
+    float distance; // 0 when the shapes overlap
+    int iterations;
+};
+
+// Gilbert-Johnson-Keerthi distance between two convex polygons, it only touches the shapes through support
+// points (the farthest vertex in a direction), so its cost grows with the iteration count rather than with the
+// product of the vertex counts like SAT.
+class GJK
+{
+public:
+    // distances below this count as touching
+    static const float tolerance;
+
+    // most vertices a shape may have, SimplexCache stores 16 bit vertex indices
+    static const size_t maxVertices = 65535;
+
+    static DistanceOutput distance(const WorldGeometry &shapeA, const WorldGeometry &shapeB, SimplexCache &cache);
+
+    static bool checkCollision(const WorldGeometry &shapeA, const WorldGeometry &shapeB, SimplexCache &cache);
+};
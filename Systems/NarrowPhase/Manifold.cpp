@@ -0,0 +1,132 @@
+#include "Manifold.h"
+#include <cfloat>
+
+// a face of B is only taken as reference if it separates clearly better than A's, so the choice does not flip
+// between frames
+static const float referenceFaceTolerance = 1e-3f;
+
+// keeps the part of the segment in[0]-in[1] where dot(normal, p) <= offset
+static int clipSegmentToLine(Vector2 out[2], const Vector2 in[2], const Vector2 &normal, float offset)
+{
+    int count = 0;
+    float distance0 = normal.dot(in[0]) - offset;
+    float distance1 = normal.dot(in[1]) - offset;
+
+    if (distance0 <= 0.0f)
+        out[count++] = in[0];
+    if (distance1 <= 0.0f)
+        out[count++] = in[1];
+
+    // the end points are on different sides of the line
+    if (distance0 * distance1 < 0.0f)
+    {
+        float interp = distance0 / (distance0 - distance1);
+        out[count] = in[0] + (in[1] - in[0]) * interp;
+        ++count;
+    }
+    return count;
+}
+
+float Manifold::findMaxSeparation(const WorldGeometry &shape, const WorldGeometry &other, size_t &edge)
+{
+    float maxSeparation = -FLT_MAX;
+    edge = 0;
+    for (size_t i = 0; i < shape.normals.size(); ++i)
+    {
+        const Vector2 &normal = shape.normals[i];
+        float offset = normal.dot(shape.vertices[i]);
+
+        // deepest vertex of other below this edge
+        float separation = FLT_MAX;
+        for (const auto &vert : other.vertices)
+        {
+            float distance = normal.dot(vert) - offset;
+            separation = distance < separation ? distance : separation;
+        }
+
+        if (separation > maxSeparation)
+        {
+            maxSeparation = separation;
+            edge = i;
+        }
+    }
+    return maxSeparation;
+}
+
+bool Manifold::collide(const WorldGeometry &shapeA, const WorldGeometry &shapeB, ContactManifold &out)
+{
+    if (shapeA.vertices.size() < 3 || shapeB.vertices.size() < 3)
+        return false;
+
+    size_t edgeA;
+    float separationA = findMaxSeparation(shapeA, shapeB, edgeA);
+    if (separationA > 0.0f)
+        return false;
+
+    size_t edgeB;
+    float separationB = findMaxSeparation(shapeB, shapeA, edgeB);
+    if (separationB > 0.0f)
+        return false;
+
+    const WorldGeometry *reference = &shapeA;
+    const WorldGeometry *incident = &shapeB;
+    size_t referenceEdge = edgeA;
+    bool flip = false;
+    if (separationB > separationA + referenceFaceTolerance)
+    {
+        reference = &shapeB;
+        incident = &shapeA;
+        referenceEdge = edgeB;
+        flip = true;
+    }
+
+    const Vector2 &referenceNormal = reference->normals[referenceEdge];
+
+    // incident edge: the one whose normal is most anti-parallel to the reference normal
+    size_t incidentEdge = 0;
+    float minDot = FLT_MAX;
+    for (size_t i = 0; i < incident->normals.size(); ++i)
+    {
+        float d = referenceNormal.dot(incident->normals[i]);
+        if (d < minDot)
+        {
+            minDot = d;
+            incidentEdge = i;
+        }
+    }
+
+    ContactManifold manifold;
+    manifold.normal = flip ? referenceNormal * -1.0f : referenceNormal;
+    manifold.depth = flip ? -separationB : -separationA;
+
+    Vector2 incidentPoints[2] = {incident->vertices[incidentEdge],
+                                 incident->vertices[(incidentEdge + 1) % incident->vertices.size()]};
+
+    const Vector2 &v1 = reference->vertices[referenceEdge];
+    const Vector2 &v2 = reference->vertices[(referenceEdge + 1) % reference->vertices.size()];
+    Vector2 tangent = (v2 - v1).normalize();
+
+    // clip the incident edge to the slab between the side planes of the reference edge, a degenerate result
+    // leaves the manifold without points
+    Vector2 clipPoints1[2];
+    Vector2 clipPoints2[2];
+    if (clipSegmentToLine(clipPoints1, incidentPoints, tangent * -1.0f, -tangent.dot(v1)) == 2 &&
+        clipSegmentToLine(clipPoints2, clipPoints1, tangent, tangent.dot(v2)) == 2)
+    {
+        // keep the points behind the reference face
+        float frontOffset = referenceNormal.dot(v1);
+        for (int i = 0; i < 2; ++i)
+        {
+            float separation = referenceNormal.dot(clipPoints2[i]) - frontOffset;
+            if (separation <= 0.0f)
+            {
+                manifold.points[manifold.pointCount] = clipPoints2[i] - referenceNormal * (separation * 0.5f);
+                manifold.pointDepths[manifold.pointCount] = -separation;
+                ++manifold.pointCount;
+            }
+        }
+    }
+
+    out = manifold;
+    return true;
+}
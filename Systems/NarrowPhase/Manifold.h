@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../Math/Vector2.h"
+#include "../../Components/WorldGeometry.h"
+
+// What a response solver needs to push two overlapping polygons apart
+struct ContactManifold
+{
+    Vector2 normal;      // unit axis of minimum penetration, pointing from A to B
+    float depth;         // how far B has to move along normal to separate
+    int pointCount;      // 0, 1 or 2
+    Vector2 points[2];   // contact points, half way between the two surfaces
+    float pointDepths[2];
+
+    ContactManifold() : depth(0.0f), pointCount(0) {}
+};
+
+// Reference / incident edge clipping (as in Box2D's b2CollidePolygons): the edge of either polygon with the largest
+// separation becomes the reference face, the other polygon's edge facing it most directly is clipped against the
+// reference face's side planes and points behind the face are kept. Costs O(nA * nB) like SAT, without building or
+// allocating any polygon.
+class Manifold
+{
+public:
+    // false when the shapes are separated, out is left untouched then
+    static bool collide(const WorldGeometry &shapeA, const WorldGeometry &shapeB, ContactManifold &out);
+
+private:
+    // largest signed distance of other from any edge of shape, and that edge
+    static float findMaxSeparation(const WorldGeometry &shape, const WorldGeometry &other, size_t &edge);
+};
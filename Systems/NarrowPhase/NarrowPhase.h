@@ -0,0 +1,10 @@
+#pragma once
+
+// Narrow phase test CollisionSystem runs on a candidate pair. Auto takes SAT for small polygons and GJK once the
+// pair has enough vertices for GJK to win (see gjk_bench).
+enum class NarrowPhaseType
+{
+    SAT,
+    GJK,
+    Auto
+};
@@ -1,5 +1,12 @@
 #include "SAT.h"
 #include <cfloat>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 bool SAT::checkCollision(const std::vector<Vector2> &shapeA, const std::vector<Vector2> &shapeB)
 {
@@ -52,3 +59,248 @@ bool SAT::checkCollision(const std::vector<Vector2> &shapeA, const std::vector<V
     // No separating axis found, collision detected
     return true;
 }
+
+
+#if defined(__AVX2__)
+
+const size_t SAT::laneWidth = 8;
+
+// projects every vertex of shape onto (axisX, axisY), eight at a time
+static inline void project(const SoAPolygon &shape, float axisX, float axisY, float &minOut, float &maxOut)
+{
+    __m256 ax = _mm256_set1_ps(axisX);
+    __m256 ay = _mm256_set1_ps(axisY);
+    __m256 minV = _mm256_set1_ps(FLT_MAX);
+    __m256 maxV = _mm256_set1_ps(-FLT_MAX);
+    for (size_t i = 0; i < shape.paddedCount; i += 8)
+    {
+        __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(shape.x + i), ax), _mm256_mul_ps(_mm256_loadu_ps(shape.y + i), ay));
+        minV = _mm256_min_ps(minV, p);
+        maxV = _mm256_max_ps(maxV, p);
+    }
+
+    // fold the two halves, then the four lanes
+    __m128 minH = _mm_min_ps(_mm256_castps256_ps128(minV), _mm256_extractf128_ps(minV, 1));
+    __m128 maxH = _mm_max_ps(_mm256_castps256_ps128(maxV), _mm256_extractf128_ps(maxV, 1));
+    minH = _mm_min_ps(minH, _mm_shuffle_ps(minH, minH, _MM_SHUFFLE(1, 0, 3, 2)));
+    maxH = _mm_max_ps(maxH, _mm_shuffle_ps(maxH, maxH, _MM_SHUFFLE(1, 0, 3, 2)));
+    minH = _mm_min_ss(minH, _mm_shuffle_ps(minH, minH, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxH = _mm_max_ss(maxH, _mm_shuffle_ps(maxH, maxH, _MM_SHUFFLE(2, 3, 0, 1)));
+    minOut = _mm_cvtss_f32(minH);
+    maxOut = _mm_cvtss_f32(maxH);
+}
+
+#elif defined(__SSE2__)
+
+const size_t SAT::laneWidth = 4;
+
+// projects every vertex of shape onto (axisX, axisY), four at a time
+static inline void project(const SoAPolygon &shape, float axisX, float axisY, float &minOut, float &maxOut)
+{
+    __m128 ax = _mm_set1_ps(axisX);
+    __m128 ay = _mm_set1_ps(axisY);
+    __m128 minV = _mm_set1_ps(FLT_MAX);
+    __m128 maxV = _mm_set1_ps(-FLT_MAX);
+    for (size_t i = 0; i < shape.paddedCount; i += 4)
+    {
+        __m128 p = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(shape.x + i), ax), _mm_mul_ps(_mm_loadu_ps(shape.y + i), ay));
+        minV = _mm_min_ps(minV, p);
+        maxV = _mm_max_ps(maxV, p);
+    }
+
+    minV = _mm_min_ps(minV, _mm_shuffle_ps(minV, minV, _MM_SHUFFLE(1, 0, 3, 2)));
+    maxV = _mm_max_ps(maxV, _mm_shuffle_ps(maxV, maxV, _MM_SHUFFLE(1, 0, 3, 2)));
+    minV = _mm_min_ss(minV, _mm_shuffle_ps(minV, minV, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxV = _mm_max_ss(maxV, _mm_shuffle_ps(maxV, maxV, _MM_SHUFFLE(2, 3, 0, 1)));
+    minOut = _mm_cvtss_f32(minV);
+    maxOut = _mm_cvtss_f32(maxV);
+}
+
+#else
+
+const size_t SAT::laneWidth = 1;
+
+static inline void project(const SoAPolygon &shape, float axisX, float axisY, float &minOut, float &maxOut)
+{
+    float minP = FLT_MAX, maxP = -FLT_MAX;
+    for (size_t i = 0; i < shape.count; ++i)
+    {
+        float p = shape.x[i] * axisX + shape.y[i] * axisY;
+        minP = p < minP ? p : minP;
+        maxP = p > maxP ? p : maxP;
+    }
+    minOut = minP;
+    maxOut = maxP;
+}
+
+#endif
+
+bool SAT::separatedByEdge(const SoAPolygon &edges, const SoAPolygon &other, size_t edge)
+{
+    // perpendicular of the edge prev -> edge, its length only scales both intervals alike
+    size_t prev = edge == 0 ? edges.count - 1 : edge - 1;
+    float axisX = edges.y[edge] - edges.y[prev];
+    float axisY = edges.x[prev] - edges.x[edge];
+
+    float minA, maxA, minB, maxB;
+    project(edges, axisX, axisY, minA, maxA);
+    project(other, axisX, axisY, minB, maxB);
+    return maxA < minB || maxB < minA;
+}
+
+bool SAT::separatedByEdges(const SoAPolygon &edges, const SoAPolygon &other)
+{
+    for (size_t i = 0; i < edges.count; ++i)
+    {
+        if (separatedByEdge(edges, other, i))
+            return true;
+    }
+    return false;
+}
+
+bool SAT::checkCollision(const SoAPolygon &shapeA, const SoAPolygon &shapeB)
+{
+    if (shapeA.count == 0 || shapeB.count == 0)
+        return false;
+    return !separatedByEdges(shapeA, shapeB) && !separatedByEdges(shapeB, shapeA);
+}
+
+SeparatingAxis SAT::findSeparatingAxis(const SoAPolygon &shapeA, const SoAPolygon &shapeB)
+{
+    const SoAPolygon *shapes[2] = {&shapeA, &shapeB};
+    SeparatingAxis axis;
+    for (std::uint8_t shape = 0; shape < 2; ++shape)
+    {
+        for (size_t edge = 0; edge < shapes[shape]->count; ++edge)
+        {
+            if (separatedByEdge(*shapes[shape], *shapes[1 - shape], edge))
+            {
+                axis.shape = shape;
+                axis.edge = static_cast<std::uint16_t>(edge);
+                return axis;
+            }
+        }
+    }
+    return axis;
+}
+
+typedef bool (*FixedKernel)(const SoAPolygon &, const SoAPolygon &);
+
+// row / column order of the kernel table: triangle, quad, symmetric quad, pentagon, hexagon, symmetric hexagon
+static int fixedKernelIndex(size_t count, bool symmetric)
+{
+    switch (count)
+    {
+    case 3:
+        return 0;
+    case 4:
+        return symmetric ? 2 : 1;
+    case 5:
+        return 3;
+    case 6:
+        return symmetric ? 5 : 4;
+    default:
+        return -1;
+    }
+}
+
+static bool vectorisedKernel(const SoAPolygon &shapeA, const SoAPolygon &shapeB)
+{
+    return SAT::checkCollision(shapeA, shapeB);
+}
+
+// pentagons get neither halved axes nor short enough loops, sat_bench shows the SIMD kernel beating the
+// unrolled one for them, so their row and column fall back to it
+#define SAT_KERNEL_ROW(NA, SA)                                                                 \
+    {                                                                                          \
+        &SAT::checkCollision<NA, 3, SA, false>, &SAT::checkCollision<NA, 4, SA, false>,        \
+            &SAT::checkCollision<NA, 4, SA, true>, &vectorisedKernel,                          \
+            &SAT::checkCollision<NA, 6, SA, false>, &SAT::checkCollision<NA, 6, SA, true>      \
+    }
+
+static const FixedKernel fixedKernels[6][6] = {
+    SAT_KERNEL_ROW(3, false),
+    SAT_KERNEL_ROW(4, false),
+    SAT_KERNEL_ROW(4, true),
+    {&vectorisedKernel, &vectorisedKernel, &vectorisedKernel, &vectorisedKernel, &vectorisedKernel, &vectorisedKernel},
+    SAT_KERNEL_ROW(6, false),
+    SAT_KERNEL_ROW(6, true)};
+
+#undef SAT_KERNEL_ROW
+
+bool SAT::checkCollision(const WorldGeometry &shapeA, const WorldGeometry &shapeB)
+{
+    SoAPolygon a = {shapeA.xs.data(), shapeA.ys.data(), shapeA.vertices.size(), shapeA.xs.size()};
+    SoAPolygon b = {shapeB.xs.data(), shapeB.ys.data(), shapeB.vertices.size(), shapeB.xs.size()};
+
+    int indexA = fixedKernelIndex(a.count, shapeA.symmetric);
+    int indexB = fixedKernelIndex(b.count, shapeB.symmetric);
+    if (indexA >= 0 && indexB >= 0)
+        return fixedKernels[indexA][indexB](a, b);
+
+    return checkCollision(a, b);
+}
+
+// The same table for the memoised test, its kernels report which axis separated the shapes
+typedef SeparatingAxis (*FixedAxisKernel)(const SoAPolygon &, const SoAPolygon &);
+
+static SeparatingAxis vectorisedAxisKernel(const SoAPolygon &shapeA, const SoAPolygon &shapeB)
+{
+    return SAT::findSeparatingAxis(shapeA, shapeB);
+}
+
+#define SAT_AXIS_KERNEL_ROW(NA, SA)                                                                \
+    {                                                                                              \
+        &SAT::findSeparatingAxis<NA, 3, SA, false>, &SAT::findSeparatingAxis<NA, 4, SA, false>,    \
+            &SAT::findSeparatingAxis<NA, 4, SA, true>, &vectorisedAxisKernel,                      \
+            &SAT::findSeparatingAxis<NA, 6, SA, false>, &SAT::findSeparatingAxis<NA, 6, SA, true>  \
+    }
+
+static const FixedAxisKernel fixedAxisKernels[6][6] = {
+    SAT_AXIS_KERNEL_ROW(3, false),
+    SAT_AXIS_KERNEL_ROW(4, false),
+    SAT_AXIS_KERNEL_ROW(4, true),
+    {&vectorisedAxisKernel, &vectorisedAxisKernel, &vectorisedAxisKernel, &vectorisedAxisKernel, &vectorisedAxisKernel, &vectorisedAxisKernel},
+    SAT_AXIS_KERNEL_ROW(6, false),
+    SAT_AXIS_KERNEL_ROW(6, true)};
+
+#undef SAT_AXIS_KERNEL_ROW
+
+bool SAT::checkCollision(const WorldGeometry &shapeA, const WorldGeometry &shapeB, SeparatingAxis &axis, size_t &axesTested)
+{
+    SoAPolygon shapes[2] = {{shapeA.xs.data(), shapeA.ys.data(), shapeA.vertices.size(), shapeA.xs.size()},
+                            {shapeB.xs.data(), shapeB.ys.data(), shapeB.vertices.size(), shapeB.xs.size()}};
+    if (shapes[0].count == 0 || shapes[1].count == 0)
+        return false;
+
+    // the kernel the dispatching test above picks, and the edges it projects onto: pentagons fall back to the
+    // vectorised kernel, which tests every edge even of a symmetric shape
+    int indexA = fixedKernelIndex(shapes[0].count, shapeA.symmetric);
+    int indexB = fixedKernelIndex(shapes[1].count, shapeB.symmetric);
+    bool fixed = indexA >= 0 && indexB >= 0;
+    bool halved = fixed && shapes[0].count != 5 && shapes[1].count != 5;
+    size_t edgeCounts[2] = {halved && shapeA.symmetric ? shapes[0].count / 2 : shapes[0].count,
+                            halved && shapeB.symmetric ? shapes[1].count / 2 : shapes[1].count};
+
+    // last frame's axis still separates most pairs that were apart
+    if (axis.shape < 2 && axis.edge < edgeCounts[axis.shape])
+    {
+        ++axesTested;
+        if (separatedByEdge(shapes[axis.shape], shapes[1 - axis.shape], axis.edge))
+            return false;
+    }
+
+    // otherwise the full test, on the same kernel the dispatching test runs
+    if (fixed)
+        axis = fixedAxisKernels[indexA][indexB](shapes[0], shapes[1]);
+    else
+        axis = findSeparatingAxis(shapes[0], shapes[1]);
+
+    if (axis.shape == 2)
+    {
+        axesTested += edgeCounts[0] + edgeCounts[1];
+        return true;
+    }
+    axesTested += axis.shape == 0 ? axis.edge + 1 : edgeCounts[0] + axis.edge + 1;
+    return false;
+}
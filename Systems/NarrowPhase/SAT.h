@@ -1,10 +1,69 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include "../../Math/Vector2.h"
+#include "../../Components/WorldGeometry.h"
+
+// Polygon as structure of arrays, x and y hold count vertices followed by padding up to paddedCount, a multiple of
+// SAT::laneWidth. Padding entries must repeat a real vertex.
+struct SoAPolygon
+{
+    const float *x;
+    const float *y;
+    size_t count;
+    size_t paddedCount;
+};
+
+// Edge whose perpendicular separated two shapes, remembered between frames so it can be tried first. shape is 0
+// for the first shape passed to the test, 1 for the second, 2 while no axis is known.
+struct SeparatingAxis
+{
+    std::uint8_t shape;
+    std::uint16_t edge; // the edge ending at vertex edge
+
+    SeparatingAxis() : shape(2), edge(0) {}
+};
 
 class SAT
 {
 public:
+    // floats processed per instruction by the compiled kernel, 8 with AVX2, 4 with SSE2, 1 for the scalar fallback
+    static const size_t laneWidth;
+
     static bool checkCollision(const std::vector<Vector2> &shapeA, const std::vector<Vector2> &shapeB);
+
+    // Vectorised test, axes are the raw edge perpendiculars since a yes / no overlap answer does not need them
+    // normalised, and it returns on the first separating axis
+    static bool checkCollision(const SoAPolygon &shapeA, const SoAPolygon &shapeB);
+
+    // Vectorised test reporting the first separating axis, shape is 2 if the polygons overlap
+    static SeparatingAxis findSeparatingAxis(const SoAPolygon &shapeA, const SoAPolygon &shapeB);
+
+    // Fully unrolled test for an NA-gon against an NB-gon. A centrally symmetric polygon has opposite edges
+    // parallel, so only the first half of its edges need testing.
+    template <size_t NA, size_t NB, bool SymmetricA = false, bool SymmetricB = false>
+    static bool checkCollision(const SoAPolygon &shapeA, const SoAPolygon &shapeB);
+
+    // Picks the fixed size kernel when both shapes have 3 to 6 vertices, otherwise runs the vectorised test
+    static bool checkCollision(const WorldGeometry &shapeA, const WorldGeometry &shapeB);
+
+    // Same answer as the test above, but tries axis first and, if that does not separate the shapes, runs the same
+    // kernel as the test above and leaves the separating axis it found in axis (or resets it if they overlap). Adds
+    // the number of axes projected to axesTested.
+    static bool checkCollision(const WorldGeometry &shapeA, const WorldGeometry &shapeB, SeparatingAxis &axis, size_t &axesTested);
+
+    // Unrolled counterpart of the vectorised findSeparatingAxis, testing the same axes as checkCollision<NA, NB, ...>
+    template <size_t NA, size_t NB, bool SymmetricA = false, bool SymmetricB = false>
+    static SeparatingAxis findSeparatingAxis(const SoAPolygon &shapeA, const SoAPolygon &shapeB);
+
+private:
+    static bool separatedByEdge(const SoAPolygon &edges, const SoAPolygon &other, size_t edge);
+    static bool separatedByEdges(const SoAPolygon &edges, const SoAPolygon &other);
+
+    // index of the first of the first Axes edges whose perpendicular separates the shapes, Axes if none does
+    template <size_t N, size_t Axes, size_t M>
+    static size_t separatingEdge(const float *edgesX, const float *edgesY, const float *otherX, const float *otherY);
 };
+
+#include "SAT.inl"
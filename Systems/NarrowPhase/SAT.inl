@@ -0,0 +1,69 @@
+#pragma once
+
+template <size_t N, size_t Axes, size_t M>
+size_t SAT::separatingEdge(const float *edgesX, const float *edgesY, const float *otherX, const float *otherY)
+{
+    for (size_t i = 0; i < Axes; ++i)
+    {
+        size_t prev = i == 0 ? N - 1 : i - 1;
+        float axisX = edgesY[i] - edgesY[prev];
+        float axisY = edgesX[prev] - edgesX[i];
+
+        float minA = edgesX[0] * axisX + edgesY[0] * axisY;
+        float maxA = minA;
+        for (size_t j = 1; j < N; ++j)
+        {
+            float p = edgesX[j] * axisX + edgesY[j] * axisY;
+            minA = p < minA ? p : minA;
+            maxA = p > maxA ? p : maxA;
+        }
+
+        float minB = otherX[0] * axisX + otherY[0] * axisY;
+        float maxB = minB;
+        for (size_t j = 1; j < M; ++j)
+        {
+            float p = otherX[j] * axisX + otherY[j] * axisY;
+            minB = p < minB ? p : minB;
+            maxB = p > maxB ? p : maxB;
+        }
+
+        if (maxA < minB || maxB < minA)
+            return i;
+    }
+    return Axes;
+}
+
+template <size_t NA, size_t NB, bool SymmetricA, bool SymmetricB>
+bool SAT::checkCollision(const SoAPolygon &shapeA, const SoAPolygon &shapeB)
+{
+    static_assert(NA >= 3 && NB >= 3, "polygons need at least 3 vertices");
+    static_assert((!SymmetricA || NA % 2 == 0) && (!SymmetricB || NB % 2 == 0), "only even polygons can be centrally symmetric");
+
+    const size_t axesA = SymmetricA ? NA / 2 : NA;
+    const size_t axesB = SymmetricB ? NB / 2 : NB;
+    return separatingEdge<NA, axesA, NB>(shapeA.x, shapeA.y, shapeB.x, shapeB.y) == axesA &&
+           separatingEdge<NB, axesB, NA>(shapeB.x, shapeB.y, shapeA.x, shapeA.y) == axesB;
+}
+
+template <size_t NA, size_t NB, bool SymmetricA, bool SymmetricB>
+SeparatingAxis SAT::findSeparatingAxis(const SoAPolygon &shapeA, const SoAPolygon &shapeB)
+{
+    const size_t axesA = SymmetricA ? NA / 2 : NA;
+    const size_t axesB = SymmetricB ? NB / 2 : NB;
+
+    SeparatingAxis axis;
+    size_t edge = separatingEdge<NA, axesA, NB>(shapeA.x, shapeA.y, shapeB.x, shapeB.y);
+    if (edge < axesA)
+    {
+        axis.shape = 0;
+        axis.edge = static_cast<std::uint16_t>(edge);
+        return axis;
+    }
+    edge = separatingEdge<NB, axesB, NA>(shapeB.x, shapeB.y, shapeA.x, shapeA.y);
+    if (edge < axesB)
+    {
+        axis.shape = 1;
+        axis.edge = static_cast<std::uint16_t>(edge);
+    }
+    return axis;
+}
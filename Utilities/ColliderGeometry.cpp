@@ -0,0 +1,90 @@
+#include "ColliderGeometry.h"
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool ColliderGeometry::update(const TransformComponent &transform, ColliderComponent &collider)
+{
+    WorldGeometry &world = collider.world;
+    if (world.valid && world.position.x == transform.position.x && world.position.y == transform.position.y &&
+        world.rotation == transform.rotation && world.scale == transform.scale &&
+        world.offset.x == collider.offset.x && world.offset.y == collider.offset.y &&
+        world.vertices.size() == collider.vertices.size())
+    {
+        return false;
+    }
+
+    size_t count = collider.vertices.size();
+    world.vertices.resize(count);
+    world.normals.resize(count);
+
+    // Convert rotation to radians, sin and cos once per entity instead of once per vertex
+    float rotationRad = transform.rotation * (M_PI / 180.0f);
+    float cosR = std::cos(rotationRad);
+    float sinR = std::sin(rotationRad);
+    Vector2 origin = transform.position + collider.offset;
+
+    Vector2 min(FLT_MAX, FLT_MAX);
+    Vector2 max(-FLT_MAX, -FLT_MAX);
+    for (size_t i = 0; i < count; ++i)
+    {
+        Vector2 localVert = collider.vertices[i] * transform.scale;
+        Vector2 worldVert(origin.x + localVert.x * cosR - localVert.y * sinR,
+                          origin.y + localVert.x * sinR + localVert.y * cosR);
+        world.vertices[i] = worldVert;
+
+        min.x = std::min(min.x, worldVert.x);
+        min.y = std::min(min.y, worldVert.y);
+        max.x = std::max(max.x, worldVert.x);
+        max.y = std::max(max.y, worldVert.y);
+    }
+    world.aabb = AABB(min, max);
+
+    size_t paddedCount = (count + WorldGeometry::soaPadding - 1) / WorldGeometry::soaPadding * WorldGeometry::soaPadding;
+    world.xs.resize(paddedCount);
+    world.ys.resize(paddedCount);
+    for (size_t i = 0; i < paddedCount; ++i)
+    {
+        const Vector2 &vert = world.vertices[i < count ? i : 0];
+        world.xs[i] = vert.x;
+        world.ys[i] = vert.y;
+    }
+
+    // regular polygons with an even vertex count (squares, hexagons) are symmetric about their centre, every
+    // vertex mirrors the one half way around
+    world.symmetric = count >= 4 && count % 2 == 0;
+    float tolerance = 1e-4f * std::max(max.x - min.x, max.y - min.y);
+    for (size_t i = 1; world.symmetric && i < count / 2; ++i)
+    {
+        Vector2 centre = world.vertices[i] + world.vertices[i + count / 2];
+        Vector2 firstCentre = world.vertices[0] + world.vertices[count / 2];
+        world.symmetric = std::fabs(centre.x - firstCentre.x) <= tolerance && std::fabs(centre.y - firstCentre.y) <= tolerance;
+    }
+
+    // the winding decides which side of an edge is outside
+    float signedArea = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Vector2 &p1 = world.vertices[i];
+        const Vector2 &p2 = world.vertices[(i + 1) % count];
+        signedArea += p1.x * p2.y - p2.x * p1.y;
+    }
+    float outward = signedArea >= 0.0f ? 1.0f : -1.0f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Vector2 edge = world.vertices[(i + 1) % count] - world.vertices[i];
+        world.normals[i] = Vector2(edge.y * outward, -edge.x * outward).normalize();
+    }
+
+    world.position = transform.position;
+    world.rotation = transform.rotation;
+    world.scale = transform.scale;
+    world.offset = collider.offset;
+    world.valid = true;
+    return true;
+}
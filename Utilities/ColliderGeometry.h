@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../Components/TransformComponent.h"
+#include "../Components/ColliderComponent.h"
+
+class ColliderGeometry
+{
+public:
+    // Brings collider.world up to date with transform, returns true if it had to be recomputed
+    static bool update(const TransformComponent &transform, ColliderComponent &collider);
+};
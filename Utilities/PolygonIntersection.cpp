@@ -22,41 +22,78 @@ static Vector2 intersection(const Vector2 &cp1, const Vector2 &cp2, const Vector
     return Vector2((n1 * dp.x - n2 * dc.x) / n3, (n1 * dp.y - n2 * dc.y) / n3);
 }
 
-std::vector<Vector2> PolygonIntersection::computeIntersection(const std::vector<Vector2> &subjectPolygon, const std::vector<Vector2> &clipPolygon)
+// Clips subject by every edge of clip, writing each pass into the buffer the previous pass did not write. Each pass
+// adds at most one vertex, so buffers of subjectCount + clipCount vertices are enough. Returns the vertex count and
+// points result at the buffer holding it.
+static size_t clipPolygons(const Vector2 *subjectPolygon, size_t subjectCount, const Vector2 *clipPolygon, size_t clipCount,
+                           Vector2 *front, Vector2 *back, const Vector2 *&result)
 {
-    std::vector<Vector2> outputList = subjectPolygon;
+    const Vector2 *inputList = subjectPolygon;
+    size_t inputCount = subjectCount;
+    Vector2 *outputList = front;
 
-    size_t cp1Count = clipPolygon.size();
-    for (size_t i = 0; i < cp1Count; ++i)
+    for (size_t i = 0; i < clipCount && inputCount > 0; ++i)
     {
         Vector2 cp1 = clipPolygon[i];
-        Vector2 cp2 = clipPolygon[(i + 1) % cp1Count];
-
-        std::vector<Vector2> inputList = outputList;
-        outputList.clear();
-
-        if (inputList.empty())
-            return outputList;
-
-        Vector2 s = inputList.back();
+        Vector2 cp2 = clipPolygon[i + 1 < clipCount ? i + 1 : 0];
 
-        for (const Vector2 &e : inputList)
+        size_t outputCount = 0;
+        Vector2 s = inputList[inputCount - 1];
+        for (size_t j = 0; j < inputCount; ++j)
         {
+            const Vector2 &e = inputList[j];
             if (inside(e, cp1, cp2))
             {
                 if (!inside(s, cp1, cp2))
                 {
-                    outputList.push_back(intersection(cp1, cp2, s, e));
+                    outputList[outputCount++] = intersection(cp1, cp2, s, e);
                 }
-                outputList.push_back(e);
+                outputList[outputCount++] = e;
             }
             else if (inside(s, cp1, cp2))
             {
-                outputList.push_back(intersection(cp1, cp2, s, e));
+                outputList[outputCount++] = intersection(cp1, cp2, s, e);
             }
             s = e;
         }
+
+        inputList = outputList;
+        inputCount = outputCount;
+        outputList = outputList == front ? back : front;
+    }
+
+    result = inputList;
+    return inputCount;
+}
+
+size_t PolygonIntersection::computeIntersection(const Vector2 *subjectPolygon, size_t subjectCount, const Vector2 *clipPolygon, size_t clipCount, Vector2 *out)
+{
+    if (subjectCount + clipCount > maxVertices)
+        return 0;
+
+    Vector2 front[maxVertices];
+    Vector2 back[maxVertices];
+    const Vector2 *result;
+    size_t count = clipPolygons(subjectPolygon, subjectCount, clipPolygon, clipCount, front, back, result);
+    for (size_t i = 0; i < count; ++i)
+        out[i] = result[i];
+    return count;
+}
+
+std::vector<Vector2> PolygonIntersection::computeIntersection(const std::vector<Vector2> &subjectPolygon, const std::vector<Vector2> &clipPolygon)
+{
+    size_t capacity = subjectPolygon.size() + clipPolygon.size();
+    if (capacity <= maxVertices)
+    {
+        Vector2 out[maxVertices];
+        size_t count = computeIntersection(subjectPolygon.data(), subjectPolygon.size(), clipPolygon.data(), clipPolygon.size(), out);
+        return std::vector<Vector2>(out, out + count);
     }
 
-    return outputList;
+    // too large for the stack buffers
+    std::vector<Vector2> front(capacity);
+    std::vector<Vector2> back(capacity);
+    const Vector2 *result;
+    size_t count = clipPolygons(subjectPolygon.data(), subjectPolygon.size(), clipPolygon.data(), clipPolygon.size(), front.data(), back.data(), result);
+    return std::vector<Vector2>(result, result + count);
 }
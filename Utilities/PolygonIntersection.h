@@ -1,10 +1,19 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
 #include "../Math/Vector2.h"
 
 class PolygonIntersection
 {
 public:
+    // largest subjectCount + clipCount the allocation free overload accepts
+    static const size_t maxVertices = 64;
+
+    // Sutherland-Hodgman clip of two convex polygons, ping-ponging between two fixed size stack buffers. out needs
+    // room for subjectCount + clipCount vertices. Returns the vertex count, 0 if the polygons are disjoint or
+    // together have more than maxVertices vertices.
+    static size_t computeIntersection(const Vector2 *subjectPolygon, size_t subjectCount, const Vector2 *clipPolygon, size_t clipCount, Vector2 *out);
+
     static std::vector<Vector2> computeIntersection(const std::vector<Vector2> &subjectPolygon, const std::vector<Vector2> &clipPolygon);
 };
@@ -1,5 +1,7 @@
 #include <iostream>
 #include "Core/ECS.h"
+#include "Core/JobSystem.h"
+#include "Core/Tracer.h"
 #include "Systems/CollisionSystem.h"
 #include "Systems/MovementSystem.h"
 #include "Components/TransformComponent.h"
@@ -10,25 +12,34 @@
 #include <memory>
 #include <vector>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include "Utilities/PolygonIntersection.h"
 #include "Utilities/PolygonUtils.h"
 
 // Include ShapeFactory
 #include "Utilities/ShapeFactory.h"
+#include "Utilities/ColliderGeometry.h"
 
 // Include SFML for visualization
 #include <SFML/Graphics.hpp>
 
 void drawEntity(sf::RenderWindow &window, Entity *entity, bool isColliding, const std::vector<std::vector<Vector2>> &collisionPolygons);
 
+// prints when and where each job of the last frame ran and how busy every thread was
+void printJobTimings(const JobSystem &jobSystem);
+
+// the collision system's counters for the last update, one per line
+std::string formatStats(const CollisionSystem::Stats &stats);
+
 struct ShapeData
 {
     std::vector<Vector2> vertices;
     ShapeType type;
 };
 
-int main()
+int main(int argc, char **argv)
 {
     ECS ecs;
 
@@ -46,8 +57,18 @@ int main()
         {ShapeFactory::createRegularPolygon(6, 30.0f), // Hexagon
          ShapeType::Hexagon}};
 
-    // Create multiple entities
-    const int entityCount = 10;
+    // usage: collision_example [entityCount] [--trace trace.json], COLLISION_TRACE=trace.json works too
+    int entityCount = 10;
+    Tracer::startFromEnvironment();
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            Tracer::start(argv[++i]);
+        else
+            entityCount = std::atoi(argv[i]);
+    }
+
+    // Create multiple entities, as many as asked for
     for (int i = 0; i < entityCount; ++i)
     {
         auto entity = std::make_shared<Entity>();
@@ -76,6 +97,7 @@ int main()
     // Create Systems
     CollisionSystem collisionSystem(ecs);
     MovementSystem movementSystem(ecs);
+    JobSystem &jobSystem = JobSystem::shared();
 
     // Setup SFML window for visualization
     sf::RenderWindow window(sf::VideoMode(800, 600), "Collision Detection Visualization", sf::Style::Resize);
@@ -87,9 +109,22 @@ int main()
     // Pause flag
     bool isPaused = false;
 
+    // stats overlay, drawn as text when COLLISION_FONT names a font file, otherwise shown in the window title
+    bool showStats = false;
+    sf::Font statsFont;
+    const char *fontPath = std::getenv("COLLISION_FONT");
+    bool hasStatsFont = fontPath && statsFont.loadFromFile(fontPath);
+    sf::Text statsText;
+    statsText.setFont(statsFont);
+    statsText.setCharacterSize(14);
+    statsText.setFillColor(sf::Color::White);
+    statsText.setPosition(8.0f, 8.0f);
+
     // Game loop
     while (window.isOpen())
     {
+        TRACE_SCOPE("frame");
+
         // Calculate delta time
         float deltaTime = clock.restart().asSeconds();
 
@@ -107,6 +142,16 @@ int main()
                     isPaused = !isPaused; // Toggle pause state
                     std::cout << (isPaused ? "Paused" : "Unpaused") << std::endl;
                 }
+                if (event.key.code == sf::Keyboard::T)
+                {
+                    printJobTimings(jobSystem);
+                }
+                if (event.key.code == sf::Keyboard::S)
+                {
+                    showStats = !showStats;
+                    if (!showStats)
+                        window.setTitle("Collision Detection Visualization");
+                }
             }
             if (event.type == sf::Event::Resized)
             {
@@ -119,9 +164,12 @@ int main()
         // update the systems
         if (!isPaused)
         {
+            // Systems run as jobs, ordered by the components they read and write. Collision reads the transforms
+            // movement writes, so the two run one after the other, each spreading its own work over jobSystem.
             sf::Vector2u windowSize = window.getSize();
-            movementSystem.update(deltaTime, windowSize);
-            collisionSystem.update();
+            movementSystem.schedule(jobSystem, deltaTime, Vector2(static_cast<float>(windowSize.x), static_cast<float>(windowSize.y)));
+            collisionSystem.schedule(jobSystem);
+            jobSystem.run();
         }
 
         // Clear the window
@@ -130,15 +178,17 @@ int main()
         // Map to store collision polygons for each entity
         std::map<Entity *, std::vector<std::vector<Vector2>>> entityCollisionPolygons;
 
-        // Build the map from collision system data
-        for (const auto &collisionPair : collisionSystem.getIntersectionPolygons())
+        // Build the map from collision system data, the polygons are indexed like the pairs
+        const auto &collisionPairs = collisionSystem.getCollisionPairs();
+        const auto &intersectionPolygons = collisionSystem.getIntersectionPolygons();
+        for (size_t i = 0; i < collisionPairs.size(); ++i)
         {
-            Entity *entityA = collisionPair.first.first;
-            Entity *entityB = collisionPair.first.second;
-            const auto &intersectionPolygon = collisionPair.second;
+            const auto &intersectionPolygon = intersectionPolygons[i];
+            if (intersectionPolygon.empty())
+                continue;
 
-            entityCollisionPolygons[entityA].push_back(intersectionPolygon);
-            entityCollisionPolygons[entityB].push_back(intersectionPolygon);
+            entityCollisionPolygons[collisionPairs[i].entityA].push_back(intersectionPolygon);
+            entityCollisionPolygons[collisionPairs[i].entityB].push_back(intersectionPolygon);
         }
 
         // Draw entities
@@ -153,10 +203,32 @@ int main()
             drawEntity(window, entity.get(), isColliding, collisionPolygons);
         }
 
+        if (showStats)
+        {
+            std::string stats = formatStats(collisionSystem.getStats());
+            if (hasStatsFont)
+            {
+                statsText.setString(stats);
+                window.draw(statsText);
+            }
+            else
+            {
+                std::string title = stats;
+                for (char &c : title)
+                {
+                    if (c == '\n')
+                        c = ' ';
+                }
+                window.setTitle(title);
+            }
+        }
+
         // Display the contents of the window
         window.display();
     }
 
+    // writes the trace if one was asked for
+    Tracer::stop();
     return 0;
 }
 
@@ -168,23 +240,17 @@ void drawEntity(sf::RenderWindow &window, Entity *entity, bool isColliding, cons
     if (!transform || !collider)
         return;
 
+    // normally a no-op, the collision system already refreshed the cache this frame
+    ColliderGeometry::update(*transform, *collider);
+    const std::vector<Vector2> &worldVertices = collider->world.vertices;
+
     sf::ConvexShape shape;
-    size_t vertexCount = collider->vertices.size();
+    size_t vertexCount = worldVertices.size();
     shape.setPointCount(vertexCount);
 
-    // Convert rotation to radians
-    float rotationRad = transform->rotation * (M_PI / 180.0f);
-
     for (size_t i = 0; i < vertexCount; ++i)
     {
-        Vector2 localVert = collider->vertices[i] * transform->scale;
-
-        // Apply rotation
-        float rotatedX = localVert.x * std::cos(rotationRad) - localVert.y * std::sin(rotationRad);
-        float rotatedY = localVert.x * std::sin(rotationRad) + localVert.y * std::cos(rotationRad);
-
-        Vector2 worldVert = transform->position + collider->offset + Vector2(rotatedX, rotatedY);
-        shape.setPoint(i, sf::Vector2f(worldVert.x, worldVert.y));
+        shape.setPoint(i, sf::Vector2f(worldVertices[i].x, worldVertices[i].y));
     }
 
     // Set original color
@@ -218,3 +284,28 @@ void drawEntity(sf::RenderWindow &window, Entity *entity, bool isColliding, cons
         window.draw(intersectionShape);
     }
 }
+
+void printJobTimings(const JobSystem &jobSystem)
+{
+    std::cout << "frame " << jobSystem.getLastRunMilliseconds() << " ms" << std::endl;
+    for (const auto &timing : jobSystem.getTimings())
+    {
+        std::cout << "  " << timing.name << " on thread " << timing.thread << ": " << timing.startMilliseconds << " - "
+                  << timing.endMilliseconds << " ms" << std::endl;
+    }
+    const std::vector<double> &busy = jobSystem.getThreadBusyMilliseconds();
+    for (size_t i = 0; i < busy.size(); ++i)
+        std::cout << "  thread " << i << " busy " << busy[i] << " ms" << std::endl;
+}
+
+std::string formatStats(const CollisionSystem::Stats &stats)
+{
+    char text[512];
+    std::snprintf(text, sizeof(text),
+                  "tree build %.2f ms\npair query %.2f ms\nnarrow phase %.2f ms\nmerge %.2f ms\nclipping %.2f ms\n"
+                  "candidates %zu | collisions %zu | false positives %.0f%%\ntree depth %d | nodes visited %zu",
+                  stats.treeBuildMilliseconds, stats.pairQueryMilliseconds, stats.narrowPhaseMilliseconds, stats.mergeMilliseconds,
+                  stats.clippingMilliseconds, stats.candidatePairs, stats.collisions, stats.falsePositiveRatio * 100.0,
+                  stats.treeDepth, stats.nodesVisited);
+    return text;
+}